@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
+#include <math.h>
 #include <ft2build.h>
 
 #include FT_FREETYPE_H
@@ -34,15 +35,63 @@
 #include FT_MODULE_H
 #include FT_DRIVER_H
 #include FT_LCD_FILTER_H
+#include FT_FONT_FORMATS_H
+#include FT_MULTIPLE_MASTERS_H
+#include FT_COLOR_H
+#include FT_BITMAP_H
+#include FT_RENDER_H
 
 #ifdef UNIX
 #include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
 #else
 #include "mlgetopt.h"
+#endif
+
+  /* Multi-threaded runs (option `-j') need POSIX threads and thread-local */
+  /* storage so that every thread gets its own library and cache objects. */
+#if defined UNIX && ( defined __GNUC__ || defined __clang__ )
+#define BENCH_THREADS
+#define BENCH_TLS  __thread
+#include <pthread.h>
+#else
+#define BENCH_TLS  /* empty */
 #endif
 
 #include "common.h"
 
+  /* Hardware performance counters (option `-e') use `perf_event_open'. */
+#if defined UNIX && defined __linux__
+#define BENCH_PERF
+#include <stdint.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+  /* Cold-start runs (option `-D') drop the font file from the page cache */
+  /* with `posix_fadvise' and compare loading it with `fread' and `mmap'. */
+#ifdef UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#ifdef POSIX_FADV_DONTNEED
+#define BENCH_COLD
+#endif
+#endif
+
+  /* The sampling profiler (option `-Y') needs glibc's `backtrace' and */
+  /* `dladdr1'.                                                         */
+#if defined UNIX && defined __GLIBC__
+#define BENCH_SAMPLER
+#include <errno.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <link.h>
+#endif
+
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -58,10 +107,41 @@
 #endif
 
 
+  enum {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_L1D_MISSES,
+    COUNTER_LLC_MISSES,
+    COUNTER_BRANCH_MISSES,
+    N_COUNTERS
+  };
+
+
+  /* allocation statistics of a library's memory manager */
+  typedef struct  bmemstats_t_
+  {
+    unsigned long  allocs;
+    unsigned long  reallocs;
+    unsigned long  frees;
+    double         bytes;    /* allocated in total (including growth) */
+    size_t         live;
+    size_t         peak;
+
+  } bmemstats_t;
+
+
   typedef struct  btimer_t_ {
     double  t0;
     double  total;
 
+    bmemstats_t  m0;
+    bmemstats_t  mem;    /* `peak' is relative to the start */
+
+#ifdef BENCH_PERF
+    uint64_t  c0[N_COUNTERS];
+    uint64_t  counts[N_COUNTERS];
+#endif
+
   } btimer_t;
 
 
@@ -88,25 +168,140 @@
   } bcharset_t;
 
 
+  /* cache types of the cache budget sweep */
+  enum {
+    CACHE_IMAGE,
+    CACHE_SBIT,
+    CACHE_CMAP,
+    N_CACHES
+  };
+
+
+  typedef struct  bcachekey_t_
+  {
+    FT_UInt   face;     /* face ID minus one */
+    FT_UInt   size;     /* in ppem */
+    FT_ULong  index;    /* glyph index or character code */
+
+  } bcachekey_t;
+
+
+  typedef struct  bcachesweep_t_
+  {
+    int             type;
+    FTC_Manager     manager;
+    FTC_ImageCache  image_cache;
+    FTC_SBitCache   sbit_cache;
+    FTC_CMapCache   cmap_cache;
+
+    /* the working set: faces times sizes times glyphs or characters */
+    unsigned int    num_faces;
+    unsigned int    num_sizes;
+    unsigned int    num_indices;
+    unsigned int    first;      /* first glyph index if no `codes' */
+    FT_ULong*       codes;      /* character codes or glyph indices */
+    unsigned long   working_set;
+
+    int             num_lookups;    /* per iteration */
+    FT_UInt32       seed;
+
+    /* with a text workload, the lookups replay the text, indexing */
+    /* `codes', while faces and sizes are still chosen at random   */
+    unsigned int*   sequence;
+    int             num_sequence;
+    int             pos;
+
+    unsigned long   hits;       /* lookups without any allocation */
+    unsigned long   misses;
+
+  } bcachesweep_t;
+
+
+  typedef struct  bstats_t_
+  {
+    int     count;     /* number of samples */
+    double  mean;      /* all values in microseconds per operation */
+    double  median;
+    double  stddev;
+    double  p5;
+    double  p95;
+    double  p99;
+    double  ci95;      /* half width of the 95% confidence interval */
+
+  } bstats_t;
+
+
+  typedef struct  bresult_t_
+  {
+    const char*     title;
+    int             test;     /* index into `bench_desc', or -1 */
+    int             done;
+    int             iterations;
+    double          total;    /* in microseconds */
+    double*         samples;  /* us/op of every iteration after warm-up */
+    bstats_t        stats;
+    double          counters[N_COUNTERS];    /* totals, if available */
+    bmemstats_t     mem;
+    unsigned long   cache_hits;      /* cache sweeps only */
+    unsigned long   cache_misses;
+    double          output_bytes;    /* SDF tests only; per operation */
+
+    /* the settings the test was run with */
+    const char*     font;
+    long            face_index;
+    const char*     format;    /* as returned by `FT_Get_Font_Format' */
+    const char*     driver;
+    unsigned int    size;
+    FT_Int32        load_flags;
+    FT_Render_Mode  render_mode;
+    unsigned int    tt_interpreter_version;
+    unsigned int    ps_hinting_engine;
+
+  } bresult_t;
+
+
   static FT_Error
   get_face( FT_Face*  face );
 
+  static FT_Error
+  set_face_size( FT_Face  face );
+
 
   /*
    * Globals
    */
 
-#define CACHE_SIZE  1024
-#define BENCH_TIME  2.0
-#define FACE_SIZE   10
+#define CACHE_SIZE   1024
+#define BENCH_TIME   2.0
+#define FACE_SIZE    10
+#define MAX_THREADS  256
+#define MAX_SIZES    64
+#define MAX_LOOKUPS  16384    /* per iteration of a cache sweep */
+#define MIN_SAMPLES  5
+
+#define PROFILE_REPEAT   5     /* timings per glyph in per-glyph mode */
+#define PROFILE_BUCKETS  16    /* histogram from 1/8us up to 4ms      */
 
 
-  static FT_Library        lib;
-  static FTC_Manager       cache_man;
-  static FTC_CMapCache     cmap_cache;
-  static FTC_ImageCache    image_cache;
-  static FTC_SBitCache     sbit_cache;
-  static FTC_ImageTypeRec  font_type;
+  /* each thread of a multi-threaded run owns a private copy of these */
+  static BENCH_TLS FT_Library        lib;
+  static BENCH_TLS struct FT_MemoryRec_  memory_rec;
+  static BENCH_TLS bmemstats_t       mem_stats;
+  static BENCH_TLS FTC_Manager       cache_man;
+  static BENCH_TLS FTC_CMapCache     cmap_cache;
+  static BENCH_TLS FTC_ImageCache    image_cache;
+  static BENCH_TLS FTC_SBitCache     sbit_cache;
+  static BENCH_TLS FTC_ImageTypeRec  font_type;
+
+  static BENCH_TLS bresult_t*  results;
+  static BENCH_TLS int         num_results;
+  static BENCH_TLS int         max_results;
+  static BENCH_TLS int         worker;    /* set in spawned threads */
+  static BENCH_TLS int         current_test = -1;
+
+  static int  use_counters;
+  static int  show_memory;
+  static int  show_stats;
 
 
   enum {
@@ -122,6 +317,16 @@
     FT_BENCH_GET_BBOX,
     FT_BENCH_GET_CBOX,
     FT_BENCH_NEW_FACE_AND_LOAD_GLYPH,
+    N_FT_BENCH_DEFAULT,         /* the tests run without option `-b' */
+
+    FT_BENCH_VARIATIONS = N_FT_BENCH_DEFAULT,
+    FT_BENCH_OPEN_ALL,
+    FT_BENCH_COLOR,
+    FT_BENCH_SDF,
+    FT_BENCH_KERNING,
+    FT_BENCH_RASTER,
+    FT_BENCH_OUTLINE,
+    FT_BENCH_BITMAP,
     N_FT_BENCH
   };
 
@@ -141,21 +346,102 @@
     "get glyph cbox      (FT_Glyph_Get_CBox)",
 
     "open face and load glyphs",
+    "vary instances      (FT_Set_Var_Design_Coordinates)",
+    "open all faces      (file, preload, mmap)",
+    "color glyphs        (FT_LOAD_COLOR, COLR layers, BGRA blit)",
+    "signed distance     (FT_RENDER_MODE_SDF, sdf and bsdf)",
+    "kerning, advances   (FT_Get_Kerning, FT_Get_Advance)",
+    "rasterize outlines  (FT_Outline_Render, smooth and mono)",
+    "process outlines    (decompose, transform, embolden, stroke)",
+    "process bitmaps     (FT_Glyph_To_Bitmap, FT_Bitmap_*)",
     NULL
   };
 
 
-  static int    preload;
-  static char*  filename;
+  static int          preload;       /* 1: read, 2: mmap */
+  static int          cold_start;    /* option `-D' */
+
+  static int            stream_mode;     /* option `-O' */
+  static unsigned long  stream_latency;  /* in us */
+  static unsigned long  stream_chunk;    /* in bytes, 0: as requested */
+
+  static char*        filename;
+  static long         face_index = 0;
+  static const char*  font_format;
+  static const char*  font_driver;
+
+  /* corpus mode: all faces and named instances of several fonts */
+  static char**  font_files;
+  static int     num_font_files;
+  static int     max_font_files;
 
   static unsigned int  first_index = 0U;
   static unsigned int  last_index  = ~0U;
   static int           incr_index  = 1;
 
-#define FOREACH( i )  for ( i = first_index ;                          \
-                            ( first_index <= i && i <= last_index ) || \
-                            ( first_index >= i && i >= last_index ) ;  \
-                            i += incr_index )
+  /* the values given on the command line, to be clamped for every face */
+  static unsigned int  first_index_arg = 0U;
+  static unsigned int  last_index_arg  = ~0U;
+
+#define FOREACH_INDEX( i )  for ( i = first_index ;                          \
+                                  ( first_index <= i && i <= last_index ) || \
+                                  ( first_index >= i && i >= last_index ) ;  \
+                                  i += incr_index )
+
+  /* text workload (options `-W' and `-Z'): the code points in text */
+  /* order, or the distinct code points of a frequency table        */
+  static const char*  workload_name;
+  static double       zipf_exponent;         /* synthetic if > 0 */
+  static FT_ULong*    workload_codes;
+  static double*      workload_counts;       /* frequency table only */
+  static int          num_workload_codes;
+
+  /* the workload of the current face, characters and glyph indices */
+  static FT_ULong*      workload_chars;
+  static int            num_workload_chars;
+  static unsigned int*  workload;            /* with a sentinel */
+  static int            num_workload;
+  static int            num_workload_distinct;
+
+  /* the position in the workload and the range of the inner loop */
+  /* of `FOREACH'                                                   */
+  static BENCH_TLS int           workload_pos;
+  static BENCH_TLS unsigned int  range_first;
+  static BENCH_TLS unsigned int  range_last;
+
+
+  /* set the range to the next glyph of the workload, or to all */
+  /* indices at the first call if there is no workload          */
+  static int
+  workload_next( void )
+  {
+    if ( !workload )
+    {
+      range_first = first_index;
+      range_last  = last_index;
+
+      return workload_pos++ == 0;
+    }
+
+    if ( workload_pos >= num_workload )
+      return 0;
+
+    range_first = workload[workload_pos++];
+    range_last  = range_first;
+
+    return 1;
+  }
+
+
+  /* iterate over the glyphs of the workload, or the range of indices; */
+  /* without a workload, the outer loop runs once and the inner loop   */
+  /* is the same as `FOREACH_INDEX'                                    */
+#define FOREACH( i )                                                    \
+          for ( workload_pos = 0 ; workload_next() ; )                  \
+            for ( i = range_first ;                                     \
+                  ( range_first <= i && i <= range_last ) ||            \
+                  ( range_first >= i && i >= range_last ) ;             \
+                  i += incr_index )
 
   static FT_Render_Mode  render_mode = FT_RENDER_MODE_NORMAL;
   static FT_Int32        load_flags  = FT_LOAD_DEFAULT;
@@ -171,9 +457,42 @@
   static char  ps_hinting_engine_names[2][10] = { "freetype",
                                                   "adobe" };
 
+  static unsigned int  tt_interpreter_version;
+  static unsigned int  ps_hinting_engine;
+  static int           lcd_filter = -1;    /* -1 means library default */
+
+  /* the `custom' filter of the render matrix (option `-X'), also used */
+  /* for all tests if given with option `-L'                           */
+  static unsigned char  lcd_weights[5] = { 0x00, 0x40, 0x80, 0x40, 0x00 };
+  static int            use_lcd_weights;
+  static int            render_matrix;
+  static int            share_threads;     /* option `-U' */
+  static int            engine_matrix;
+
+  static const char*    test_string;
+  static unsigned int   face_size      = FACE_SIZE;
+  static unsigned int   face_size_arg  = FACE_SIZE;
+  static unsigned int   sweep_sizes[MAX_SIZES];
+  static int            num_sweep_sizes;
+  static unsigned long  max_bytes      = CACHE_SIZE * 1024;
+  static int            max_iter       = 0;
+  static double         max_time       = BENCH_TIME;
+  static int            warmup_iter    = 0;
+  static double         target_error   = 0.0;  /* adaptive mode if > 0 */
+  static int            compare_cached = 0;
+  static int            num_threads    = 1;
+  static int            profile_top    = 0;    /* per-glyph mode if > 0 */
+  static int            cache_faces    = 0;    /* cache sweep if > 0    */
+  static int            cache_sizes    = 0;
+  static const char*    output_name;
+  static const char*    baseline_save;
+  static const char*    baseline_compare;
+  static double         regress_threshold = 5.0;    /* in percent */
+
 
   /*
-   * Dummy face requester (the face object is already loaded)
+   * Dummy face requester (the face object is already loaded); the cache
+   * manager gets its own reference, which it releases when done
    */
 
   static FT_Error
@@ -187,7 +506,26 @@
 
     *aface = (FT_Face)request_data;
 
-    return FT_Err_Ok;
+    return FT_Reference_Face( *aface );
+  }
+
+
+  /*
+   * Face requester of the cache budget sweep: every face ID gets its own
+   * face object, which the cache manager destroys when it evicts the face
+   */
+
+  static FT_Error
+  new_face_requester( FTC_FaceID  face_id,
+                      FT_Library  library,
+                      FT_Pointer  request_data,
+                      FT_Face*    aface )
+  {
+    FT_UNUSED( face_id );
+    FT_UNUSED( library );
+    FT_UNUSED( request_data );
+
+    return get_face( aface );
   }
 
 
@@ -234,6 +572,11 @@
     struct timespec  tv;
 
 
+    /* CPU time would hide the time threads spend waiting for each */
+    /* other and the time cold-start runs spend waiting for I/O    */
+    if ( num_threads > 1 || share_threads || cold_start )
+      clock_gettime( CLOCK_MONOTONIC, &tv );
+    else
 #ifdef _POSIX_CPUTIME
     clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &tv );
 #else
@@ -248,733 +591,8874 @@
 #endif /* _POSIX_TIMERS */
   }
 
-#define TIMER_START( timer )  ( timer )->t0 = get_time()
-#define TIMER_STOP( timer )   ( timer )->total += get_time() - ( timer )->t0
-#define TIMER_GET( timer )    ( timer )->total
-#define TIMER_RESET( timer )  ( timer )->total = 0
-
 
   /*
-   * Bench code
+   * Hardware performance counters
    */
 
-  static void
-  benchmark( FT_Face   face,
-             btest_t*  test,
-             int       max_iter,
-             double    max_time )
+  static const char*  counter_names[N_COUNTERS] =
   {
-    int       n, done;
-    btimer_t  timer, elapsed;
-
-
-    if ( test->cache_first )
-    {
-      if ( !cache_man )
-      {
-        printf( "  %-25s no cache manager\n", test->title );
+    "cycles",
+    "instructions",
+    "L1d_misses",
+    "LLC_misses",
+    "branch_misses"
+  };
 
-        return;
-      }
+#ifdef BENCH_PERF
 
-      TIMER_RESET( &timer );
-      test->bench( &timer, face, test->user_data );
-    }
+  /* all counters of a thread form one group, read with a single call */
+  static BENCH_TLS int  perf_fd = -1;
+  static BENCH_TLS int  perf_fds[N_COUNTERS];
+  static BENCH_TLS int  perf_slot[N_COUNTERS];   /* position in group data */
+  static BENCH_TLS int  perf_count;
 
-    printf( "  %-25s ", test->title );
-    fflush( stdout );
 
-    TIMER_RESET( &timer );
-    TIMER_RESET( &elapsed );
+  static int
+  perf_open( int  counter,
+             int  group_fd )
+  {
+    struct perf_event_attr  attr;
 
-    for ( n = 0, done = 0; !max_iter || n < max_iter; n++ )
-    {
-      TIMER_START( &elapsed );
 
-      done += test->bench( &timer, face, test->user_data );
+    memset( &attr, 0, sizeof ( attr ) );
 
-      TIMER_STOP( &elapsed );
+    attr.size           = sizeof ( attr );
+    attr.disabled       = group_fd < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP;
 
-      if ( TIMER_GET( &elapsed ) > 1E6 * max_time )
-        break;
+    switch ( counter )
+    {
+    case COUNTER_CYCLES:
+      attr.type   = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+
+    case COUNTER_INSTRUCTIONS:
+      attr.type   = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+
+    case COUNTER_L1D_MISSES:
+      attr.type   = PERF_TYPE_HW_CACHE;
+      attr.config = PERF_COUNT_HW_CACHE_L1D                |
+                    PERF_COUNT_HW_CACHE_OP_READ << 8       |
+                    PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+      break;
+
+    case COUNTER_LLC_MISSES:
+      attr.type   = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_CACHE_MISSES;
+      break;
+
+    default: /* COUNTER_BRANCH_MISSES */
+      attr.type   = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
     }
 
-    if ( done )
-      printf( "%10.3f us/op %10d done\n",
-              TIMER_GET( &timer ) / (double)done, done );
-    else
-      printf( "no error-free calls\n" );
+    /* count the calling thread on any CPU */
+    return (int)syscall( __NR_perf_event_open, &attr, 0, -1, group_fd, 0 );
   }
 
 
-  /*
-   * Various tests
-   */
-
+  /* set up the counters of the calling thread; return 0 on failure */
   static int
-  test_load( btimer_t*  timer,
-             FT_Face    face,
-             void*      user_data )
+  perf_init( void )
   {
-    unsigned int  i;
-    int           done = 0;
-
-    FT_UNUSED( user_data );
+    int  i;
 
 
-    TIMER_START( timer );
+    perf_fd    = -1;
+    perf_count = 0;
 
-    FOREACH( i )
+    for ( i = 0; i < N_COUNTERS; i++ )
     {
-      if ( !FT_Load_Glyph( face, i, load_flags ) )
-        done++;
+      perf_fds[i]  = perf_open( i, perf_fd );
+      perf_slot[i] = -1;
+
+      if ( perf_fds[i] < 0 )
+        continue;
+
+      if ( perf_fd < 0 )
+        perf_fd = perf_fds[i];
+      perf_slot[i] = perf_count++;
     }
 
-    TIMER_STOP( timer );
+    if ( perf_fd < 0 )
+      return 0;
 
-    return done;
+    ioctl( perf_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP );
+    ioctl( perf_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP );
+
+    return 1;
   }
 
 
-  static int
-  test_load_advances( btimer_t*  timer,
-                      FT_Face    face,
-                      void*      user_data )
+  /* call only if `perf_init' succeeded */
+  static void
+  perf_done( void )
   {
-    int        done = 0;
-    FT_Fixed*  advances;
-    FT_ULong   flags = *((FT_ULong*)user_data);
-    FT_UInt    start, count;
+    int  i;
 
 
-    if ( incr_index > 0 )
+    for ( i = 0; i < N_COUNTERS; i++ )
     {
-      start = first_index;
-      count = last_index - first_index + 1;
+      if ( perf_fds[i] >= 0 )
+        close( perf_fds[i] );
+      perf_fds[i] = -1;
     }
-    else
+
+    perf_fd = -1;
+  }
+
+
+  static void
+  perf_read( uint64_t*  values )
+  {
+    uint64_t  data[1 + N_COUNTERS];
+    int       i;
+
+
+    if ( perf_fd < 0 ||
+         read( perf_fd, data, sizeof ( data ) ) < (ssize_t)sizeof ( data[0] ) )
     {
-      start = last_index;
-      count = first_index - last_index + 1;
+      memset( values, 0, N_COUNTERS * sizeof ( uint64_t ) );
+      return;
     }
 
-    advances = (FT_Fixed *)calloc( sizeof ( FT_Fixed ), (size_t)count );
+    for ( i = 0; i < N_COUNTERS; i++ )
+      values[i] = perf_slot[i] < 0 ? 0 : data[1 + perf_slot[i]];
+  }
 
-    TIMER_START( timer );
 
-    FT_Get_Advances( face, start, count, (FT_Int32)flags, advances );
-    done += (int)count;
+#endif /* BENCH_PERF */
 
-    TIMER_STOP( timer );
 
-    free( advances );
+  /*
+   * Sampling profiler
+   */
 
-    return done;
-  }
+#ifdef BENCH_SAMPLER
 
+#define SAMPLE_INTERVAL  1000     /* in microseconds of CPU time */
+#define SAMPLE_DEPTH     48
+#define SAMPLE_SKIP      2        /* the handler and the signal trampoline */
+#define MAX_SAMPLES      16384
+#define MAX_SYMBOLS      4096
+#define ADDR_CACHE       16384    /* a power of 2 */
+#define FLAT_LINES       25
 
-  static int
-  test_render( btimer_t*  timer,
-               FT_Face    face,
-               void*      user_data )
+  typedef struct  bsymbol_t_
   {
-    unsigned int  i;
-    int           done = 0;
+    char*          name;
+    unsigned long  self;
+    unsigned long  total;
+    int            stamp;     /* last sample counted in `total' */
 
-    FT_UNUSED( user_data );
+  } bsymbol_t;
 
 
-    FOREACH( i )
-    {
-      if ( FT_Load_Glyph( face, i, load_flags ) )
-        continue;
+  static int            sample_test = -1;   /* option `-Y' */
+  static const char*    folded_name;        /* option `-y' */
+  static FILE*          folded_file;
 
-      TIMER_START( timer );
-      if ( !FT_Render_Glyph( face->glyph, render_mode ) )
-        done++;
-      TIMER_STOP( timer );
-    }
+  /* only the timed sections of this timer are sampled */
+  static btimer_t*      sampled_timer;
 
-    return done;
-  }
+  static volatile sig_atomic_t  sampler_on;
+  static volatile sig_atomic_t  num_stack_samples;
+  static volatile sig_atomic_t  dropped_samples;
 
+  /* raw return addresses, filled by the signal handler */
+  static void**         sample_frames;
+  static int*           sample_depths;
 
-  static int
-  test_embolden( btimer_t*  timer,
-                 FT_Face    face,
-                 void*      user_data )
+  /* the same stacks as symbol indices, leaf first */
+  static int*           sample_symbols;
+
+  static bsymbol_t      symbols[MAX_SYMBOLS];
+  static int            num_symbols;
+
+  static const void*    addr_keys[ADDR_CACHE];
+  static int            addr_symbols[ADDR_CACHE];
+
+
+  static void
+  sampler_handler( int  sig )
   {
-    unsigned int  i;
-    int           done = 0;
+    int  saved_errno = errno;
+    int  n           = num_stack_samples;
 
-    FT_UNUSED( user_data );
+    FT_UNUSED( sig );
 
 
-    FOREACH( i )
+    if ( !sampler_on )
+      ;
+    else if ( n < MAX_SAMPLES )
     {
-      if ( FT_Load_Glyph( face, i, load_flags ) )
-        continue;
-
-      TIMER_START( timer );
-      FT_GlyphSlot_Embolden( face->glyph );
-      done++;
-      TIMER_STOP( timer );
+      sample_depths[n]  = backtrace( sample_frames + n * SAMPLE_DEPTH,
+                                     SAMPLE_DEPTH );
+      num_stack_samples = n + 1;
     }
+    else
+      dropped_samples++;
 
-    return done;
+    errno = saved_errno;
   }
 
 
+  /* return 0 on failure */
   static int
-  test_stroke( btimer_t*  timer,
-               FT_Face    face,
-               void*      user_data )
+  sampler_init( void )
   {
-    FT_Glyph      glyph;
-    FT_Stroker    stroker;
-    unsigned int  i;
-    int           done = 0;
+    struct sigaction  action;
+    void*             frame[1];
 
-    FT_UNUSED( user_data );
 
+    sample_frames  = (void**)malloc( MAX_SAMPLES * SAMPLE_DEPTH *
+                                       sizeof ( void* ) );
+    sample_depths  = (int*)malloc( MAX_SAMPLES * sizeof ( int ) );
+    sample_symbols = (int*)malloc( MAX_SAMPLES * SAMPLE_DEPTH *
+                                     sizeof ( int ) );
+    if ( !sample_frames || !sample_depths || !sample_symbols )
+      return 0;
 
-    FT_Stroker_New( lib, &stroker );
-    FT_Stroker_Set( stroker, face->size->metrics.y_ppem,
-                    FT_STROKER_LINECAP_ROUND,
-                    FT_STROKER_LINEJOIN_ROUND,
-                    0 );
+    /* the first call of `backtrace' loads the unwinder, */
+    /* which must not happen in the signal handler       */
+    backtrace( frame, 1 );
 
-    FOREACH( i )
-    {
-      if ( FT_Load_Glyph( face, i, load_flags ) )
-        continue;
+    memset( &action, 0, sizeof ( action ) );
+    action.sa_handler = sampler_handler;
+    action.sa_flags   = SA_RESTART;
+    sigemptyset( &action.sa_mask );
 
-      if ( FT_Get_Glyph( face->glyph, &glyph ) )
-        continue;
+    return !sigaction( SIGPROF, &action, NULL );
+  }
 
-      TIMER_START( timer );
-      FT_Glyph_Stroke( &glyph, stroker, 1 );
-      TIMER_STOP( timer );
 
-      FT_Done_Glyph( glyph );
-      done++;
-    }
+  static void
+  sampler_done( void )
+  {
+    int  k;
 
-    return done;
+
+    for ( k = 0; k < num_symbols; k++ )
+      free( symbols[k].name );
+
+    free( sample_frames );
+    free( sample_depths );
+    free( sample_symbols );
+
+    if ( folded_file )
+      fclose( folded_file );
   }
 
 
-  static int
-  test_get_glyph( btimer_t*  timer,
-                  FT_Face    face,
-                  void*      user_data )
+  static void
+  sampler_start( btimer_t*  timer )
   {
-    FT_Glyph      glyph;
-    unsigned int  i;
-    int           done = 0;
+    struct itimerval  interval;
 
-    FT_UNUSED( user_data );
 
+    num_stack_samples = 0;
+    dropped_samples   = 0;
+    sampled_timer     = timer;
 
-    FOREACH( i )
-    {
-      if ( FT_Load_Glyph( face, i, load_flags ) )
-        continue;
+    interval.it_interval.tv_sec  = 0;
+    interval.it_interval.tv_usec = SAMPLE_INTERVAL;
+    interval.it_value            = interval.it_interval;
 
-      TIMER_START( timer );
-      if ( !FT_Get_Glyph( face->glyph, &glyph ) )
-      {
-        FT_Done_Glyph( glyph );
-        done++;
-      }
-      TIMER_STOP( timer );
-    }
+    setitimer( ITIMER_PROF, &interval, NULL );
+  }
 
-    return done;
+
+  static void
+  sampler_stop( void )
+  {
+    struct itimerval  interval;
+
+
+    memset( &interval, 0, sizeof ( interval ) );
+    setitimer( ITIMER_PROF, &interval, NULL );
+
+    sampler_on    = 0;
+    sampled_timer = NULL;
   }
 
 
+  /* map a code address to a symbol index; functions missing in the */
+  /* dynamic symbol table are lumped together by object file         */
   static int
-  test_get_cbox( btimer_t*  timer,
-                 FT_Face    face,
-                 void*      user_data )
+  sampler_symbol( const void*  addr )
   {
-    FT_Glyph      glyph;
-    FT_BBox       bbox;
-    unsigned int  i;
-    int           done = 0;
+    unsigned long  h = ( (unsigned long)addr >> 2 ) & ( ADDR_CACHE - 1 );
+    unsigned long  probe;
+    Dl_info        info;
+    ElfW( Sym )*   sym  = NULL;
+    const char*    name = "[unknown]";
+    char           buf[256];
+    int            k;
 
-    FT_UNUSED( user_data );
+
+    for ( probe = 0; probe < ADDR_CACHE; probe++ )
+    {
+      unsigned long  slot = ( h + probe ) & ( ADDR_CACHE - 1 );
 
 
-    FOREACH( i )
+      if ( addr_keys[slot] == addr )
+        return addr_symbols[slot];
+      if ( !addr_keys[slot] )
+        break;
+    }
+
+    if ( dladdr1( addr, &info, (void**)&sym, RTLD_DL_SYMENT ) )
     {
-      if ( FT_Load_Glyph( face, i, load_flags ) )
-        continue;
+      /* `dladdr' returns the nearest symbol below `addr', */
+      /* which might belong to a different function        */
+      if ( info.dli_sname && sym                                   &&
+           ( !sym->st_size                                       ||
+             (const char*)addr < (const char*)info.dli_saddr +
+                                   sym->st_size                  ) )
+        name = info.dli_sname;
+      else if ( info.dli_fname )
+      {
+        snprintf( buf, sizeof ( buf ), "[%s]", ft_basename( info.dli_fname ) );
+        name = buf;
+      }
+    }
 
-      if ( FT_Get_Glyph( face->glyph, &glyph ) )
-        continue;
+    for ( k = 0; k < num_symbols; k++ )
+      if ( !strcmp( symbols[k].name, name ) )
+        break;
 
-      TIMER_START( timer );
-      FT_Glyph_Get_CBox( glyph, FT_GLYPH_BBOX_PIXELS, &bbox );
-      TIMER_STOP( timer );
+    if ( k == num_symbols )
+    {
+      if ( num_symbols == MAX_SYMBOLS )
+        return MAX_SYMBOLS - 1;     /* unlikely; share the last entry */
 
-      FT_Done_Glyph( glyph );
-      done++;
+      symbols[k].name = strdup( name );
+      if ( !symbols[k].name )
+        return MAX_SYMBOLS - 1;
+
+      num_symbols++;
     }
 
-    return done;
+    if ( probe < ADDR_CACHE )
+    {
+      unsigned long  slot = ( h + probe ) & ( ADDR_CACHE - 1 );
+
+
+      addr_keys[slot]    = addr;
+      addr_symbols[slot] = k;
+    }
+
+    return k;
   }
 
 
   static int
-  test_get_bbox( btimer_t*  timer,
-                 FT_Face    face,
-                 void*      user_data )
+  compare_symbols( const void*  a,
+                   const void*  b )
   {
-    FT_BBox       bbox;
-    unsigned int  i;
-    int           done  = 0;
-    FT_Matrix     rot30 = { 0xDDB4, -0x8000, 0x8000, 0xDDB4 };
+    unsigned long  x = symbols[*(const int*)a].self;
+    unsigned long  y = symbols[*(const int*)b].self;
 
-    FT_UNUSED( user_data );
 
+    return x < y ? 1 : x > y ? -1 : 0;
+  }
 
-    FOREACH( i )
+
+  /* order the samples by their stacks, for the folded output */
+  static int
+  compare_stacks( const void*  a,
+                  const void*  b )
+  {
+    int   m = *(const int*)a;
+    int   n = *(const int*)b;
+    int*  s = sample_symbols + m * SAMPLE_DEPTH;
+    int*  t = sample_symbols + n * SAMPLE_DEPTH;
+    int   k;
+
+
+    for ( k = 0; k < sample_depths[m] && k < sample_depths[n]; k++ )
+      if ( s[k] != t[k] )
+        return s[k] - t[k];
+
+    return sample_depths[m] - sample_depths[n];
+  }
+
+
+  /* print the flat profile of the samples taken for test `title' */
+  /* and append the folded stacks to the file of option `-y'       */
+  static void
+  sampler_report( const char*  title )
+  {
+    int   count = num_stack_samples;
+    int*  order;
+    int   k, m, n;
+
+
+    for ( k = 0; k < num_symbols; k++ )
     {
-      FT_Outline*  outline;
+      symbols[k].self  = 0;
+      symbols[k].total = 0;
+      symbols[k].stamp = -1;
+    }
 
+    for ( n = 0; n < count; n++ )
+    {
+      void**  frames = sample_frames + n * SAMPLE_DEPTH;
+      int*    syms   = sample_symbols + n * SAMPLE_DEPTH;
+      int     depth  = 0;
 
-      if ( FT_Load_Glyph( face, i, load_flags ) )
-        continue;
 
-      outline = &face->glyph->outline;
+      for ( k = SAMPLE_SKIP; k < sample_depths[n]; k++ )
+      {
+        /* return addresses point after the call instruction, */
+        /* which might be the start of the next function      */
+        const char*  addr = (const char*)frames[k];
 
-      /* rotate outline by 30 degrees */
-      FT_Outline_Transform( outline, &rot30 );
 
-      TIMER_START( timer );
-      FT_Outline_Get_BBox( outline, &bbox );
-      TIMER_STOP( timer );
+        if ( k > SAMPLE_SKIP )
+          addr--;
 
-      done++;
+        m = sampler_symbol( addr );
+
+        syms[depth++] = m;
+        if ( symbols[m].stamp != n )
+        {
+          symbols[m].stamp = n;
+          symbols[m].total++;
+        }
+      }
+
+      sample_depths[n] = depth;
+      if ( depth )
+        symbols[syms[0]].self++;
     }
 
-    return done;
-  }
+    printf( "  %-25s profile of %d samples (%d dropped):\n",
+            "", count, (int)dropped_samples );
+    if ( !count )
+      return;
 
+    order = (int*)malloc( (size_t)( num_symbols > count ? num_symbols
+                                                          : count ) *
+                            sizeof ( int ) );
+    if ( !order )
+      return;
 
-  static int
-  test_get_char_index( btimer_t*  timer,
-                       FT_Face    face,
-                       void*      user_data )
-  {
-    bcharset_t*  charset = (bcharset_t*)user_data;
-    int          i, done = 0;
+    for ( k = 0; k < num_symbols; k++ )
+      order[k] = k;
+    qsort( order, (size_t)num_symbols, sizeof ( int ), compare_symbols );
 
+    printf( "  %-25s    self    total  function\n", "" );
+    for ( k = 0; k < num_symbols && k < FLAT_LINES; k++ )
+    {
+      bsymbol_t*  s = symbols + order[k];
 
-    TIMER_START( timer );
 
-    for ( i = 0; i < charset->size; i++ )
+      if ( !s->self )
+        break;
+
+      printf( "  %-25s %6.1f%%  %6.1f%%  %s\n",
+              "",
+              100.0 * (double)s->self / count,
+              100.0 * (double)s->total / count,
+              s->name );
+    }
+
+    if ( folded_name && !folded_file )
     {
-      if ( FT_Get_Char_Index(face, charset->code[i]) )
-        done++;
+      folded_file = fopen( folded_name, "w" );
+      if ( !folded_file )
+      {
+        fprintf( stderr, "couldn't open `%s'\n", folded_name );
+        folded_name = NULL;
+      }
     }
 
-    TIMER_STOP( timer );
+    if ( folded_file )
+    {
+      /* one line per distinct stack, root first, below the test title */
+      for ( n = 0; n < count; n++ )
+        order[n] = n;
+      qsort( order, (size_t)count, sizeof ( int ), compare_stacks );
 
-    return done;
+      for ( n = 0; n < count; n = m )
+      {
+        int*  syms = sample_symbols + order[n] * SAMPLE_DEPTH;
+
+
+        for ( m = n + 1; m < count; m++ )
+          if ( compare_stacks( order + n, order + m ) )
+            break;
+
+        fputs( title, folded_file );
+        for ( k = sample_depths[order[n]] - 1; k >= 0; k-- )
+          fprintf( folded_file, ";%s", symbols[syms[k]].name );
+        fprintf( folded_file, " %d\n", m - n );
+      }
+    }
+
+    free( order );
   }
 
+#endif /* BENCH_SAMPLER */
 
-  static int
-  test_cmap_cache( btimer_t*  timer,
-                   FT_Face    face,
-                   void*      user_data )
+
+  /*
+   * Allocation accounting
+   */
+
+  /* every block carries its size so that `free' can update the stats */
+  typedef union  bmemheader_t_
   {
-    bcharset_t*  charset = (bcharset_t*)user_data;
-    int          i, done = 0;
+    size_t       size;
+    double       align1;
+    void*        align2;
+    long double  align3;
 
-    FT_UNUSED( face );
+  } bmemheader_t;
 
 
-    if ( !cmap_cache )
-    {
-      if ( FTC_CMapCache_New( cache_man, &cmap_cache ) )
-        return 0;
-    }
+  /* set by `cache_manager_new' to zero the next block */
+  static BENCH_TLS int  alloc_zeroed;
 
-    TIMER_START( timer );
 
-    for ( i = 0; i < charset->size; i++ )
+  static void*
+  bench_alloc( FT_Memory  memory,
+               long       size )
+  {
+    bmemstats_t*   stats = (bmemstats_t*)memory->user;
+    bmemheader_t*  block;
+
+
+    if ( alloc_zeroed )
     {
-      if ( FTC_CMapCache_Lookup( cmap_cache,
-                                 font_type.face_id,
-                                 0,
-                                 charset->code[i] ) )
-        done++;
+      alloc_zeroed = 0;
+      block        = (bmemheader_t*)calloc( 1, sizeof ( bmemheader_t ) +
+                                                 (size_t)size );
     }
+    else
+      block = (bmemheader_t*)malloc( sizeof ( bmemheader_t ) +
+                                       (size_t)size );
+    if ( !block )
+      return NULL;
 
-    TIMER_STOP( timer );
+    block->size = (size_t)size;
 
-    return done;
+    stats->allocs++;
+    stats->bytes += (double)size;
+    stats->live  += (size_t)size;
+    if ( stats->live > stats->peak )
+      stats->peak = stats->live;
+
+    return block + 1;
   }
 
 
-  static int
-  test_image_cache( btimer_t*  timer,
-                    FT_Face    face,
-                    void*      user_data )
+  static void
+  bench_free( FT_Memory  memory,
+              void*      ptr )
   {
-    FT_Glyph      glyph;
-    unsigned int  i;
-    int           done = 0;
+    bmemstats_t*   stats = (bmemstats_t*)memory->user;
+    bmemheader_t*  block = (bmemheader_t*)ptr - 1;
 
-    FT_UNUSED( face );
-    FT_UNUSED( user_data );
 
+    stats->frees++;
+    stats->live -= block->size;
 
-    if ( !image_cache )
-    {
-      if ( FTC_ImageCache_New( cache_man, &image_cache ) )
-        return 0;
-    }
+    free( block );
+  }
 
-    TIMER_START( timer );
 
-    FOREACH( i )
-    {
-      if ( !FTC_ImageCache_Lookup( image_cache,
-                                   &font_type,
-                                   i,
-                                   &glyph,
-                                   NULL ) )
-        done++;
-    }
+  static void*
+  bench_realloc( FT_Memory  memory,
+                 long       cur_size,
+                 long       new_size,
+                 void*      ptr )
+  {
+    bmemstats_t*   stats = (bmemstats_t*)memory->user;
+    bmemheader_t*  block = (bmemheader_t*)ptr - 1;
 
-    TIMER_STOP( timer );
+    FT_UNUSED( cur_size );
 
-    return done;
+
+    block = (bmemheader_t*)realloc( block,
+                                    sizeof ( bmemheader_t ) +
+                                      (size_t)new_size );
+    if ( !block )
+      return NULL;
+
+    stats->reallocs++;
+    stats->live -= block->size;
+    stats->live += (size_t)new_size;
+    if ( new_size > (long)block->size )
+      stats->bytes += (double)( (size_t)new_size - block->size );
+    if ( stats->live > stats->peak )
+      stats->peak = stats->live;
+
+    block->size = (size_t)new_size;
+
+    return block + 1;
   }
 
 
-  static int
-  test_sbit_cache( btimer_t*  timer,
-                   FT_Face    face,
-                   void*      user_data )
+  /* like `FTC_Manager_New'; some FreeType versions allocate the    */
+  /* `FTC_ManagerRec' with `FT_QNEW' and leave `cur_weight' unset,   */
+  /* so that block (the first one allocated) is zeroed, unlike all   */
+  /* others                                                          */
+  static FT_Error
+  cache_manager_new( FT_Library          library,
+                     FT_UInt             max_faces,
+                     FT_UInt             max_sizes,
+                     FT_ULong            bytes,
+                     FTC_Face_Requester  requester,
+                     FT_Pointer          req_data,
+                     FTC_Manager*        amanager )
   {
-    FTC_SBit      glyph;
-    unsigned int  i;
-    int           done = 0;
+    FT_Error  error;
 
-    FT_UNUSED( face );
-    FT_UNUSED( user_data );
 
+    alloc_zeroed = 1;
+    error        = FTC_Manager_New( library,
+                                    max_faces,
+                                    max_sizes,
+                                    bytes,
+                                    requester,
+                                    req_data,
+                                    amanager );
+    alloc_zeroed = 0;
 
-    if ( !sbit_cache )
-    {
-      if ( FTC_SBitCache_New( cache_man, &sbit_cache ) )
-        return 0;
-    }
+    return error;
+  }
 
-    TIMER_START( timer );
 
-    FOREACH( i )
-    {
-      if ( !FTC_SBitCache_Lookup( sbit_cache,
-                                  &font_type,
-                                  i,
-                                  &glyph,
-                                  NULL ) )
-        done++;
-    }
+  /*
+   * Timer with optional hardware and allocation counters
+   */
 
-    TIMER_STOP( timer );
+  static void
+  timer_start( btimer_t*  timer )
+  {
+#ifdef BENCH_PERF
+    if ( perf_fd >= 0 )
+      perf_read( timer->c0 );
+#endif
 
-    return done;
+    /* track the peak of live bytes anew for every section */
+    mem_stats.peak = mem_stats.live;
+    timer->m0      = mem_stats;
+
+    timer->t0 = get_time();
+
+#ifdef BENCH_SAMPLER
+    if ( timer == sampled_timer )
+      sampler_on = 1;
+#endif
   }
 
 
-  static int
-  test_cmap_iter( btimer_t*  timer,
-                  FT_Face    face,
-                  void*      user_data )
+  static void
+  timer_stop( btimer_t*  timer )
   {
-    FT_UInt   idx;
-    FT_ULong  charcode;
-
-    FT_UNUSED( user_data );
+#ifdef BENCH_SAMPLER
+    if ( timer == sampled_timer )
+      sampler_on = 0;
+#endif
 
+    timer->total += get_time() - timer->t0;
 
-    TIMER_START( timer );
+    timer->mem.allocs   += mem_stats.allocs - timer->m0.allocs;
+    timer->mem.reallocs += mem_stats.reallocs - timer->m0.reallocs;
+    timer->mem.frees    += mem_stats.frees - timer->m0.frees;
+    timer->mem.bytes    += mem_stats.bytes - timer->m0.bytes;
+    if ( mem_stats.peak - timer->m0.live > timer->mem.peak )
+      timer->mem.peak = mem_stats.peak - timer->m0.live;
 
-    charcode = FT_Get_First_Char( face, &idx );
-    while ( idx != 0 )
-      charcode = FT_Get_Next_Char( face, charcode, &idx );
+#ifdef BENCH_PERF
+    if ( perf_fd >= 0 )
+    {
+      uint64_t  c1[N_COUNTERS];
+      int       i;
 
-    TIMER_STOP( timer );
 
-    return 1;
+      perf_read( c1 );
+      for ( i = 0; i < N_COUNTERS; i++ )
+        timer->counts[i] += c1[i] - timer->c0[i];
+    }
+#endif
   }
 
 
-  static int
-  test_new_face( btimer_t*  timer,
-                 FT_Face    face,
-                 void*      user_data )
+  static void
+  timer_reset( btimer_t*  timer )
   {
-    FT_Face  bench_face;
+    timer->total = 0;
+    memset( &timer->mem, 0, sizeof ( timer->mem ) );
+#ifdef BENCH_PERF
+    memset( timer->counts, 0, sizeof ( timer->counts ) );
+#endif
+  }
+
+#define TIMER_START( timer )  timer_start( timer )
+#define TIMER_STOP( timer )   timer_stop( timer )
+#define TIMER_GET( timer )    ( timer )->total
+#define TIMER_RESET( timer )  timer_reset( timer )
+
+
+  /*
+   * Thread synchronization
+   */
+
+#ifdef BENCH_THREADS
+
+  static pthread_mutex_t  sync_mutex = PTHREAD_MUTEX_INITIALIZER;
+  static pthread_cond_t   sync_cond  = PTHREAD_COND_INITIALIZER;
+  static int              sync_count;
+  static unsigned int     sync_round;
+  static int              thread_failed;  /* protected by `sync_mutex' */
+
+
+  /* set `thread_failed' and release all threads waiting in `bench_sync' */
+  static void
+  bench_fail( void )
+  {
+    pthread_mutex_lock( &sync_mutex );
+    thread_failed = 1;
+    pthread_cond_broadcast( &sync_cond );
+    pthread_mutex_unlock( &sync_mutex );
+  }
+
+
+  /* wait until all worker threads have reached the same point; */
+  /* return non-zero at once if a thread has failed             */
+  static int
+  bench_sync( void )
+  {
+    unsigned int  round;
+    int           failed;
+
+
+    if ( !worker )
+      return 0;
+
+    pthread_mutex_lock( &sync_mutex );
+
+    round = sync_round;
+    if ( !thread_failed && ++sync_count == num_threads )
+    {
+      sync_count = 0;
+      sync_round++;
+      pthread_cond_broadcast( &sync_cond );
+    }
+    else
+      while ( round == sync_round && !thread_failed )
+        pthread_cond_wait( &sync_cond, &sync_mutex );
+
+    failed = thread_failed;
+
+    pthread_mutex_unlock( &sync_mutex );
+
+    return failed;
+  }
+
+#else
+
+#define bench_fail()  do { } while ( 0 )
+#define bench_sync()  0
+
+#endif /* BENCH_THREADS */
+
+
+  /*
+   * Bench code
+   */
+
+  static bresult_t*
+  add_result( const char*  title )
+  {
+    bresult_t*  result;
+
+
+    if ( num_results == max_results )
+    {
+      int         new_max = max_results ? 2 * max_results : 32;
+      bresult_t*  new_results;
+
+
+      new_results = (bresult_t*)realloc( results,
+                                         (size_t)new_max *
+                                           sizeof ( bresult_t ) );
+      if ( !new_results )
+        return NULL;
+
+      results     = new_results;
+      max_results = new_max;
+    }
+
+    result = results + num_results++;
+
+    result->title      = title;
+    result->test       = current_test;
+    result->done       = 0;
+    result->iterations = 0;
+    result->total      = 0.0;
+    result->samples    = NULL;
+
+    memset( &result->stats, 0, sizeof ( bstats_t ) );
+    memset( result->counters, 0, sizeof ( result->counters ) );
+    memset( &result->mem, 0, sizeof ( result->mem ) );
+    result->cache_hits   = 0;
+    result->cache_misses = 0;
+    result->output_bytes = 0.0;
+
+    result->font                   = filename;
+    result->face_index             = face_index;
+    result->format                 = font_format;
+    result->driver                 = font_driver;
+    result->size                   = face_size;
+    result->load_flags             = load_flags;
+    result->render_mode            = render_mode;
+    result->tt_interpreter_version = tt_interpreter_version;
+    result->ps_hinting_engine      = ps_hinting_engine;
+
+    return result;
+  }
+
+
+  static void
+  free_results( bresult_t*  res,
+                int         count )
+  {
+    int  k;
+
+
+    for ( k = 0; k < count; k++ )
+      free( res[k].samples );
+    free( res );
+  }
+
+
+  static void
+  skip_message( btest_t*     test,
+                const char*  reason )
+  {
+    if ( !worker )
+      printf( "  %-25s %s\n", test->title, reason );
+  }
+
+
+  /* skip `test' instead of calling `benchmark'; in a worker thread, */
+  /* take part in the synchronization round of the benchmark, which  */
+  /* the other threads skip as well                                  */
+  static void
+  skip( btest_t*     test,
+        const char*  reason )
+  {
+    skip_message( test, reason );
+    (void)bench_sync();
+  }
+
+
+  /* like `skip', but for errors that might happen in a single worker */
+  /* thread only: the multi-threaded run is abandoned, otherwise the  */
+  /* other threads would wait for this one forever                    */
+  static void
+  fail( btest_t*     test,
+        const char*  reason )
+  {
+    skip_message( test, reason );
+    if ( worker )
+      bench_fail();
+  }
+
+
+  /* attach cache hit counts to the result of the test started with */
+  /* result number `first' and print the hit ratio                  */
+  static void
+  add_hits( int            first,
+            unsigned long  hits,
+            unsigned long  misses )
+  {
+    if ( num_results > first )
+    {
+      results[first].cache_hits   = hits;
+      results[first].cache_misses = misses;
+    }
+
+    if ( hits + misses && !worker )
+      printf( "  %-25s %.1f%% hits, %.1f%% misses (%lu lookups)\n",
+              "",
+              100.0 * (double)hits / (double)( hits + misses ),
+              100.0 * (double)misses / (double)( hits + misses ),
+              hits + misses );
+  }
+
+
+  /* attach the average output size to the result of the test */
+  /* started with result number `first' and print it           */
+  static void
+  add_output_bytes( int     first,
+                    double  bytes )
+  {
+    if ( num_results > first )
+      results[first].output_bytes = bytes;
+
+    if ( !worker )
+      printf( "  %-25s %.0f output bytes/op\n", "", bytes );
+  }
+
+
+  /*
+   * Statistics
+   */
+
+  /* two-sided 95% quantiles of Student's t-distribution, */
+  /* indexed by degrees of freedom minus one              */
+  static const double  t_95[30] =
+  {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+     2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+     2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+  };
+
+
+  static double
+  t_quantile( int  df )
+  {
+    if ( df < 1 )
+      return 0.0;
+
+    return df <= 30 ? t_95[df - 1] : 1.960;
+  }
+
+
+  static int
+  compare_doubles( const void*  a,
+                   const void*  b )
+  {
+    double  x = *(const double*)a;
+    double  y = *(const double*)b;
+
+
+    return x < y ? -1 : x > y;
+  }
+
+
+  /* linear interpolation between closest ranks of sorted samples */
+  static double
+  percentile( const double*  sorted,
+              int            count,
+              double         p )
+  {
+    double  rank = p * ( count - 1 );
+    int     lo   = (int)rank;
+
+
+    if ( lo + 1 >= count )
+      return sorted[count - 1];
+
+    return sorted[lo] + ( rank - lo ) * ( sorted[lo + 1] - sorted[lo] );
+  }
+
+
+  static void
+  compute_stats( const double*  samples,
+                 int            count,
+                 bstats_t*      stats )
+  {
+    double*  sorted;
+    double   sum = 0.0, sum2 = 0.0;
+    int      i;
+
+
+    memset( stats, 0, sizeof ( bstats_t ) );
+    if ( count < 1 )
+      return;
+
+    sorted = (double*)malloc( (size_t)count * sizeof ( double ) );
+    if ( !sorted )
+      return;
+
+    memcpy( sorted, samples, (size_t)count * sizeof ( double ) );
+    qsort( sorted, (size_t)count, sizeof ( double ), compare_doubles );
+
+    for ( i = 0; i < count; i++ )
+      sum += samples[i];
+    stats->mean = sum / count;
+
+    for ( i = 0; i < count; i++ )
+      sum2 += ( samples[i] - stats->mean ) * ( samples[i] - stats->mean );
+
+    stats->count  = count;
+    stats->stddev = count > 1 ? sqrt( sum2 / ( count - 1 ) ) : 0.0;
+    stats->ci95   = t_quantile( count - 1 ) * stats->stddev / sqrt( count );
+    stats->median = percentile( sorted, count, 0.50 );
+    stats->p5     = percentile( sorted, count, 0.05 );
+    stats->p95    = percentile( sorted, count, 0.95 );
+    stats->p99    = percentile( sorted, count, 0.99 );
+
+    free( sorted );
+  }
+
+
+  static void
+  benchmark( FT_Face   face,
+             btest_t*  test )
+  {
+    int         n, done;
+    btimer_t    timer, elapsed;
+    bresult_t*  result;
+
+    double*  samples     = NULL;
+    int      num_samples = 0;
+    int      max_samples = 0;
+    double   mean        = 0.0;    /* running mean and squared deviation */
+    double   m2          = 0.0;    /* (Welford's algorithm)              */
+
+
+    /* all threads of a multi-threaded run execute a test simultaneously */
+    if ( bench_sync() )
+      return;
+
+    if ( test->cache_first )
+    {
+      if ( !cache_man )
+      {
+        skip_message( test, "no cache manager" );
+
+        return;
+      }
+
+      TIMER_RESET( &timer );
+      test->bench( &timer, face, test->user_data );
+    }
+
+    if ( !worker )
+    {
+      printf( "  %-25s ", test->title );
+      fflush( stdout );
+    }
+
+    for ( n = 0; n < warmup_iter; n++ )
+      test->bench( &timer, face, test->user_data );
+
+    TIMER_RESET( &timer );
+    TIMER_RESET( &elapsed );
+
+#ifdef BENCH_SAMPLER
+    if ( sample_test >= 0 )
+      sampler_start( &timer );
+#endif
+
+    for ( n = 0, done = 0; !max_iter || n < max_iter; n++ )
+    {
+      double  before = TIMER_GET( &timer );
+      int     d;
+
+
+      TIMER_START( &elapsed );
+
+      d     = test->bench( &timer, face, test->user_data );
+      done += d;
+
+      TIMER_STOP( &elapsed );
+
+      if ( d > 0 )
+      {
+        double  x = ( TIMER_GET( &timer ) - before ) / d;
+        double  delta;
+
+
+        if ( num_samples == max_samples )
+        {
+          int      new_max     = max_samples ? 2 * max_samples : 64;
+          double*  new_samples = (double*)realloc( samples,
+                                                   (size_t)new_max *
+                                                     sizeof ( double ) );
+
+
+          if ( new_samples )
+          {
+            samples     = new_samples;
+            max_samples = new_max;
+          }
+        }
+
+        /* a sample that couldn't be stored is left out of the */
+        /* statistics, too                                      */
+        if ( num_samples < max_samples )
+        {
+          samples[num_samples++] = x;
+
+          delta  = x - mean;
+          mean  += delta / num_samples;
+          m2    += delta * ( x - mean );
+        }
+      }
+
+      if ( TIMER_GET( &elapsed ) > 1E6 * max_time )
+      {
+        n++;
+        break;
+      }
+
+      /* stop early once the confidence interval is tight enough */
+      if ( target_error > 0 && num_samples >= MIN_SAMPLES && mean > 0 )
+      {
+        double  ci = t_quantile( num_samples - 1 ) *
+                     sqrt( m2 / ( num_samples - 1 ) / num_samples );
+
+
+        if ( ci < target_error / 100 * mean )
+        {
+          n++;
+          break;
+        }
+      }
+    }
+
+#ifdef BENCH_SAMPLER
+    if ( sample_test >= 0 )
+      sampler_stop();
+#endif
+
+    result = add_result( test->title );
+    if ( result )
+    {
+      result->done       = done;
+      result->iterations = n;
+      result->total      = TIMER_GET( &timer );
+      result->samples    = samples;
+
+      compute_stats( samples, num_samples, &result->stats );
+
+      result->mem = timer.mem;
+
+#ifdef BENCH_PERF
+      for ( n = 0; n < N_COUNTERS; n++ )
+        result->counters[n] = (double)timer.counts[n];
+#endif
+    }
+    else
+      free( samples );
+
+    if ( worker )
+      return;
+
+    if ( done )
+      printf( "%10.3f us/op %10d done\n",
+              TIMER_GET( &timer ) / (double)done, done );
+    else
+      printf( "no error-free calls\n" );
+
+    if ( result && show_stats && result->stats.count > 1 )
+    {
+      bstats_t*  st = &result->stats;
+
+
+      printf( "  %-25s mean %.3f, median %.3f, stddev %.3f (n = %d)\n"
+              "  %-25s p5 %.3f, p95 %.3f, p99 %.3f,"
+              " 95%% CI +/-%.3f (%.1f%%)\n",
+              "", st->mean, st->median, st->stddev, st->count,
+              "", st->p5, st->p95, st->p99,
+              st->ci95, st->mean > 0 ? 100 * st->ci95 / st->mean : 0.0 );
+    }
+
+    if ( result && use_counters && done )
+    {
+      double*  c = result->counters;
+
+
+      printf( "  %-25s %.0f cycles, %.0f instructions (IPC %.2f) per op\n"
+              "  %-25s %.2f L1d, %.2f LLC, %.2f branch misses per op\n",
+              "",
+              c[COUNTER_CYCLES] / done,
+              c[COUNTER_INSTRUCTIONS] / done,
+              c[COUNTER_CYCLES] > 0
+                ? c[COUNTER_INSTRUCTIONS] / c[COUNTER_CYCLES]
+                : 0.0,
+              "",
+              c[COUNTER_L1D_MISSES] / done,
+              c[COUNTER_LLC_MISSES] / done,
+              c[COUNTER_BRANCH_MISSES] / done );
+    }
+
+    if ( result && show_memory && done )
+    {
+      bmemstats_t*  m = &result->mem;
+
+
+      printf( "  %-25s %.2f allocs, %.2f reallocs, %.0f bytes per op,"
+              " peak %lu bytes\n",
+              "",
+              (double)m->allocs / done,
+              (double)m->reallocs / done,
+              m->bytes / done,
+              (unsigned long)m->peak );
+    }
+
+#ifdef BENCH_SAMPLER
+    if ( sample_test >= 0 )
+      sampler_report( test->title );
+#endif
+  }
+
+
+  /*
+   * Various tests
+   */
+
+  static int
+  test_load( btimer_t*  timer,
+             FT_Face    face,
+             void*      user_data )
+  {
+    unsigned int  i;
+    int           done = 0;
+
+    FT_UNUSED( user_data );
+
+
+    TIMER_START( timer );
+
+    FOREACH( i )
+    {
+      if ( !FT_Load_Glyph( face, i, load_flags ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  static int
+  test_load_advances( btimer_t*  timer,
+                      FT_Face    face,
+                      void*      user_data )
+  {
+    int        done = 0;
+    FT_Fixed*  advances;
+    FT_ULong   flags = *((FT_ULong*)user_data);
+    FT_UInt    start, count;
+
+
+    if ( incr_index > 0 )
+    {
+      start = first_index;
+      count = last_index - first_index + 1;
+    }
+    else
+    {
+      start = last_index;
+      count = first_index - last_index + 1;
+    }
+
+    advances = (FT_Fixed *)calloc( sizeof ( FT_Fixed ), (size_t)count );
+
+    TIMER_START( timer );
+
+    FT_Get_Advances( face, start, count, (FT_Int32)flags, advances );
+    done += (int)count;
+
+    TIMER_STOP( timer );
+
+    free( advances );
+
+    return done;
+  }
+
+
+  static int
+  test_render( btimer_t*  timer,
+               FT_Face    face,
+               void*      user_data )
+  {
+    unsigned int  i;
+    int           done = 0;
+
+    FT_UNUSED( user_data );
+
+
+    FOREACH( i )
+    {
+      if ( FT_Load_Glyph( face, i, load_flags ) )
+        continue;
+
+      TIMER_START( timer );
+      if ( !FT_Render_Glyph( face->glyph, render_mode ) )
+        done++;
+      TIMER_STOP( timer );
+    }
+
+    return done;
+  }
+
+
+  static int
+  test_embolden( btimer_t*  timer,
+                 FT_Face    face,
+                 void*      user_data )
+  {
+    unsigned int  i;
+    int           done = 0;
+
+    FT_UNUSED( user_data );
+
+
+    FOREACH( i )
+    {
+      if ( FT_Load_Glyph( face, i, load_flags ) )
+        continue;
+
+      TIMER_START( timer );
+      FT_GlyphSlot_Embolden( face->glyph );
+      done++;
+      TIMER_STOP( timer );
+    }
+
+    return done;
+  }
+
+
+  static int
+  test_stroke( btimer_t*  timer,
+               FT_Face    face,
+               void*      user_data )
+  {
+    FT_Glyph      glyph;
+    FT_Stroker    stroker;
+    unsigned int  i;
+    int           done = 0;
+
+    FT_UNUSED( user_data );
+
+
+    FT_Stroker_New( lib, &stroker );
+    FT_Stroker_Set( stroker, face->size->metrics.y_ppem,
+                    FT_STROKER_LINECAP_ROUND,
+                    FT_STROKER_LINEJOIN_ROUND,
+                    0 );
+
+    FOREACH( i )
+    {
+      if ( FT_Load_Glyph( face, i, load_flags ) )
+        continue;
+
+      if ( FT_Get_Glyph( face->glyph, &glyph ) )
+        continue;
+
+      TIMER_START( timer );
+      FT_Glyph_Stroke( &glyph, stroker, 1 );
+      TIMER_STOP( timer );
+
+      FT_Done_Glyph( glyph );
+      done++;
+    }
+
+    return done;
+  }
+
+
+  static int
+  test_get_glyph( btimer_t*  timer,
+                  FT_Face    face,
+                  void*      user_data )
+  {
+    FT_Glyph      glyph;
+    unsigned int  i;
+    int           done = 0;
+
+    FT_UNUSED( user_data );
+
+
+    FOREACH( i )
+    {
+      if ( FT_Load_Glyph( face, i, load_flags ) )
+        continue;
+
+      TIMER_START( timer );
+      if ( !FT_Get_Glyph( face->glyph, &glyph ) )
+      {
+        FT_Done_Glyph( glyph );
+        done++;
+      }
+      TIMER_STOP( timer );
+    }
+
+    return done;
+  }
+
+
+  static int
+  test_get_cbox( btimer_t*  timer,
+                 FT_Face    face,
+                 void*      user_data )
+  {
+    FT_Glyph      glyph;
+    FT_BBox       bbox;
+    unsigned int  i;
+    int           done = 0;
+
+    FT_UNUSED( user_data );
+
+
+    FOREACH( i )
+    {
+      if ( FT_Load_Glyph( face, i, load_flags ) )
+        continue;
+
+      if ( FT_Get_Glyph( face->glyph, &glyph ) )
+        continue;
+
+      TIMER_START( timer );
+      FT_Glyph_Get_CBox( glyph, FT_GLYPH_BBOX_PIXELS, &bbox );
+      TIMER_STOP( timer );
+
+      FT_Done_Glyph( glyph );
+      done++;
+    }
+
+    return done;
+  }
+
+
+  static int
+  test_get_bbox( btimer_t*  timer,
+                 FT_Face    face,
+                 void*      user_data )
+  {
+    FT_BBox       bbox;
+    unsigned int  i;
+    int           done  = 0;
+    FT_Matrix     rot30 = { 0xDDB4, -0x8000, 0x8000, 0xDDB4 };
+
+    FT_UNUSED( user_data );
+
+
+    FOREACH( i )
+    {
+      FT_Outline*  outline;
+
+
+      if ( FT_Load_Glyph( face, i, load_flags ) )
+        continue;
+
+      outline = &face->glyph->outline;
+
+      /* rotate outline by 30 degrees */
+      FT_Outline_Transform( outline, &rot30 );
+
+      TIMER_START( timer );
+      FT_Outline_Get_BBox( outline, &bbox );
+      TIMER_STOP( timer );
+
+      done++;
+    }
+
+    return done;
+  }
+
+
+  static int
+  test_get_char_index( btimer_t*  timer,
+                       FT_Face    face,
+                       void*      user_data )
+  {
+    bcharset_t*  charset = (bcharset_t*)user_data;
+    int          i, done = 0;
+
+
+    TIMER_START( timer );
+
+    for ( i = 0; i < charset->size; i++ )
+    {
+      if ( FT_Get_Char_Index(face, charset->code[i]) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  static int
+  test_cmap_cache( btimer_t*  timer,
+                   FT_Face    face,
+                   void*      user_data )
+  {
+    bcharset_t*  charset = (bcharset_t*)user_data;
+    int          i, done = 0;
+
+    FT_UNUSED( face );
+
+
+    if ( !cmap_cache )
+    {
+      if ( FTC_CMapCache_New( cache_man, &cmap_cache ) )
+        return 0;
+    }
+
+    TIMER_START( timer );
+
+    for ( i = 0; i < charset->size; i++ )
+    {
+      if ( FTC_CMapCache_Lookup( cmap_cache,
+                                 font_type.face_id,
+                                 0,
+                                 charset->code[i] ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  static int
+  test_image_cache( btimer_t*  timer,
+                    FT_Face    face,
+                    void*      user_data )
+  {
+    FT_Glyph      glyph;
+    unsigned int  i;
+    int           done = 0;
+
+    FT_UNUSED( face );
+    FT_UNUSED( user_data );
+
+
+    if ( !image_cache )
+    {
+      if ( FTC_ImageCache_New( cache_man, &image_cache ) )
+        return 0;
+    }
+
+    TIMER_START( timer );
+
+    FOREACH( i )
+    {
+      if ( !FTC_ImageCache_Lookup( image_cache,
+                                   &font_type,
+                                   i,
+                                   &glyph,
+                                   NULL ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  static int
+  test_sbit_cache( btimer_t*  timer,
+                   FT_Face    face,
+                   void*      user_data )
+  {
+    FTC_SBit      glyph;
+    unsigned int  i;
+    int           done = 0;
+
+    FT_UNUSED( face );
+    FT_UNUSED( user_data );
+
+
+    if ( !sbit_cache )
+    {
+      if ( FTC_SBitCache_New( cache_man, &sbit_cache ) )
+        return 0;
+    }
+
+    TIMER_START( timer );
+
+    FOREACH( i )
+    {
+      if ( !FTC_SBitCache_Lookup( sbit_cache,
+                                  &font_type,
+                                  i,
+                                  &glyph,
+                                  NULL ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  /* map a number below `working_set' to a cache key */
+  static void
+  cache_key( bcachesweep_t*  cs,
+             unsigned long   n,
+             bcachekey_t*    key )
+  {
+    key->index = n % cs->num_indices;
+    n         /= cs->num_indices;
+    key->size  = face_size + n % cs->num_sizes;
+    key->face  = (FT_UInt)( n / cs->num_sizes );
+
+    if ( cs->codes )
+      key->index = cs->codes[key->index];
+    else
+      key->index += cs->first;
+  }
+
+
+  static int
+  cache_lookup( bcachesweep_t*  cs,
+                bcachekey_t*    key )
+  {
+    FTC_ImageTypeRec  type;
+    FT_Glyph          glyph;
+    FTC_SBit          sbit;
+
+
+    type.face_id = (FTC_FaceID)(size_t)( key->face + 1 );
+    type.width   = key->size;
+    type.height  = key->size;
+    type.flags   = load_flags;
+
+    switch ( cs->type )
+    {
+    case CACHE_IMAGE:
+      return !FTC_ImageCache_Lookup( cs->image_cache,
+                                     &type,
+                                     (FT_UInt)key->index,
+                                     &glyph,
+                                     NULL );
+
+    case CACHE_SBIT:
+      return !FTC_SBitCache_Lookup( cs->sbit_cache,
+                                    &type,
+                                    (FT_UInt)key->index,
+                                    &sbit,
+                                    NULL );
+
+    default:
+      return FTC_CMapCache_Lookup( cs->cmap_cache,
+                                   type.face_id,
+                                   0,
+                                   (FT_UInt32)key->index ) != 0;
+    }
+  }
+
+
+  /* look up random keys of the working set; a lookup that allocates */
+  /* memory (that is, creates a node or loads a glyph) is a miss     */
+  static int
+  test_cache_lookup( btimer_t*  timer,
+                     FT_Face    face,
+                     void*      user_data )
+  {
+    bcachesweep_t*  cs = (bcachesweep_t*)user_data;
+    int             k, done = 0;
+
+    FT_UNUSED( face );
+
+
+    TIMER_START( timer );
+
+    for ( k = 0; k < cs->num_lookups; k++ )
+    {
+      unsigned long  allocs = mem_stats.allocs;
+      bcachekey_t    key;
+
+
+      /* xorshift32 */
+      cs->seed ^= cs->seed << 13;
+      cs->seed ^= cs->seed >> 17;
+      cs->seed ^= cs->seed << 5;
+
+      if ( cs->sequence )
+      {
+        unsigned long  n = cs->working_set / cs->num_indices;
+
+
+        cache_key( cs,
+                   cs->seed % n * cs->num_indices + cs->sequence[cs->pos],
+                   &key );
+        if ( ++cs->pos == cs->num_sequence )
+          cs->pos = 0;
+      }
+      else
+        cache_key( cs, cs->seed % cs->working_set, &key );
+      done += cache_lookup( cs, &key );
+
+      if ( mem_stats.allocs != allocs )
+        cs->misses++;
+      else
+        cs->hits++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  static int
+  test_cmap_iter( btimer_t*  timer,
+                  FT_Face    face,
+                  void*      user_data )
+  {
+    FT_UInt   idx;
+    FT_ULong  charcode;
+
+    FT_UNUSED( user_data );
+
+
+    TIMER_START( timer );
+
+    charcode = FT_Get_First_Char( face, &idx );
+    while ( idx != 0 )
+      charcode = FT_Get_Next_Char( face, charcode, &idx );
+
+    TIMER_STOP( timer );
+
+    return 1;
+  }
+
+
+  static int
+  test_new_face( btimer_t*  timer,
+                 FT_Face    face,
+                 void*      user_data )
+  {
+    FT_Face  bench_face;
+
+    FT_UNUSED( face );
+    FT_UNUSED( user_data );
+
+
+    TIMER_START( timer );
+
+    if ( !get_face( &bench_face ) )
+      FT_Done_Face( bench_face );
+
+    TIMER_STOP( timer );
+
+    return 1;
+  }
+
+
+  static int
+  test_new_face_and_load_glyph( btimer_t*  timer,
+                                FT_Face    face,
+                                void*      user_data )
+  {
+    FT_Face  bench_face;
+
+    unsigned int  i;
+    int           done = 0;
+
+    FT_UNUSED( face );
+    FT_UNUSED( user_data );
+
+
+    TIMER_START( timer );
+
+    if ( !get_face( &bench_face ) )
+    {
+      FOREACH( i )
+      {
+        if ( !FT_Load_Glyph( bench_face, i, load_flags ) )
+          done++;
+      }
+
+      FT_Done_Face( bench_face );
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  /*
+   * Variable fonts
+   */
+
+#define VAR_STEPS  8    /* interpolated instances between axis extremes */
+
+
+  typedef struct  bvariation_t_
+  {
+    FT_MM_Var*      mm;
+    FT_UInt         num_axis;
+    FT_Fixed*       coords;    /* `VAR_STEPS' rows of `num_axis' values */
+    FT_UInt         step;      /* the row (or named instance) to use next */
+
+    FTC_Manager     manager;   /* the instance cache tests only */
+    FTC_ImageCache  cache;
+    int             flush;     /* drop the previous instance on a change */
+    unsigned long   hits;
+    unsigned long   misses;
+
+  } bvariation_t;
+
+
+  static FT_Fixed*
+  var_coords( bvariation_t*  var,
+              FT_UInt        step )
+  {
+    return var->coords + step * var->num_axis;
+  }
+
+
+  /* every face ID of the instance cache tests is a row of coordinates */
+  static FT_Error
+  var_face_requester( FTC_FaceID  face_id,
+                      FT_Library  library,
+                      FT_Pointer  request_data,
+                      FT_Face*    aface )
+  {
+    bvariation_t*  var  = (bvariation_t*)request_data;
+    FT_UInt        step = (FT_UInt)( (size_t)face_id - 1 );
+    FT_Error       error;
+
+    FT_UNUSED( library );
+
+
+    error = get_face( aface );
+    if ( error )
+      return error;
+
+    error = FT_Set_Var_Design_Coordinates( *aface,
+                                           var->num_axis,
+                                           var_coords( var, step ) );
+    if ( error )
+      FT_Done_Face( *aface );
+
+    return error;
+  }
+
+
+  static int
+  test_var_set( btimer_t*  timer,
+                FT_Face    face,
+                void*      user_data )
+  {
+    bvariation_t*  var = (bvariation_t*)user_data;
+    FT_UInt        k;
+    int            done = 0;
+
+
+    TIMER_START( timer );
+
+    for ( k = 0; k < VAR_STEPS; k++ )
+    {
+      if ( !FT_Set_Var_Design_Coordinates( face,
+                                           var->num_axis,
+                                           var_coords( var, k ) ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  /* every iteration loads the glyphs at the next interpolated instance */
+  static int
+  test_var_load( btimer_t*  timer,
+                 FT_Face    face,
+                 void*      user_data )
+  {
+    bvariation_t*  var = (bvariation_t*)user_data;
+    unsigned int   i;
+    int            done = 0;
+
+
+    if ( FT_Set_Var_Design_Coordinates( face,
+                                        var->num_axis,
+                                        var_coords( var, var->step ) ) )
+      return 0;
+
+    var->step = ( var->step + 1 ) % VAR_STEPS;
+
+    TIMER_START( timer );
+
+    FOREACH( i )
+    {
+      if ( !FT_Load_Glyph( face, i, load_flags ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  static int
+  test_var_named( btimer_t*  timer,
+                  FT_Face    face,
+                  void*      user_data )
+  {
+    bvariation_t*  var = (bvariation_t*)user_data;
+    FT_UInt        k;
+    int            done = 0;
+
+
+    TIMER_START( timer );
+
+    for ( k = 1; k <= var->mm->num_namedstyles; k++ )
+    {
+      if ( !FT_Set_Named_Instance( face, k ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  /* every iteration looks up the glyphs at the next instance; with */
+  /* `flush' set, the previous instance gets removed from the cache */
+  static int
+  test_var_cache( btimer_t*  timer,
+                  FT_Face    face,
+                  void*      user_data )
+  {
+    bvariation_t*     var = (bvariation_t*)user_data;
+    FTC_ImageTypeRec  type;
+    FT_Glyph          glyph;
+    unsigned int      i;
+    int               done = 0;
+
+    FT_UNUSED( face );
+
+
+    type.face_id = (FTC_FaceID)(size_t)( var->step + 1 );
+    type.width   = face_size;
+    type.height  = face_size;
+    type.flags   = load_flags;
+
+    TIMER_START( timer );
+
+    if ( var->flush )
+      FTC_Manager_RemoveFaceID(
+        var->manager,
+        (FTC_FaceID)(size_t)( ( var->step + VAR_STEPS - 1 ) % VAR_STEPS +
+                              1 ) );
+
+    FOREACH( i )
+    {
+      unsigned long  allocs = mem_stats.allocs;
+
+
+      if ( !FTC_ImageCache_Lookup( var->cache,
+                                   &type,
+                                   i,
+                                   &glyph,
+                                   NULL ) )
+        done++;
+
+      if ( mem_stats.allocs != allocs )
+        var->misses++;
+      else
+        var->hits++;
+    }
+
+    TIMER_STOP( timer );
+
+    var->step = ( var->step + 1 ) % VAR_STEPS;
+
+    return done;
+  }
+
+
+  /*
+   * Color glyphs
+   */
+
+#define BLIT_WIDTH   256    /* size of the RGB32 surface for blitting */
+#define BLIT_HEIGHT  256
+
+
+  typedef struct  bcolor_t_
+  {
+    FT_Int32    flags;       /* load flags of the bitmap tests */
+    FT_Color*   palette;
+    FT_UInt32*  surface;     /* `BLIT_WIDTH' x `BLIT_HEIGHT', RGB32 */
+
+  } bcolor_t;
+
+
+  /* composite premultiplied BGRA pixels onto the surface, as the  */
+  /* graph library of the demo programs does, clipped at its edges */
+  static void
+  blit_bgra( const FT_Bitmap*  bitmap,
+             FT_UInt32*        surface )
+  {
+    const unsigned char*  line   = bitmap->buffer;
+    unsigned int          width  = bitmap->width;
+    unsigned int          height = bitmap->rows;
+    unsigned int          x, y;
+
+
+    if ( width > BLIT_WIDTH )
+      width = BLIT_WIDTH;
+    if ( height > BLIT_HEIGHT )
+      height = BLIT_HEIGHT;
+
+    if ( bitmap->pitch < 0 )
+      line -= bitmap->pitch * (int)( bitmap->rows - 1 );
+
+    for ( y = 0; y < height; y++, line += bitmap->pitch )
+    {
+      const unsigned char*  src = line;
+      FT_UInt32*            dst = surface + y * BLIT_WIDTH;
+
+
+      for ( x = 0; x < width; x++, src += 4, dst++ )
+      {
+        unsigned int  a = src[3];
+
+
+        if ( a == 255 )
+          *dst = ( (FT_UInt32)src[2] << 16 ) |
+                 ( (FT_UInt32)src[1] << 8  ) |
+                   (FT_UInt32)src[0];
+        else if ( a )
+        {
+          unsigned int  ba = 255 - a;
+          FT_UInt32     r  = ( *dst >> 16 ) & 0xFF;
+          FT_UInt32     g  = ( *dst >> 8  ) & 0xFF;
+          FT_UInt32     b  =   *dst         & 0xFF;
+
+
+          r = r * ba / 255 + src[2];
+          g = g * ba / 255 + src[1];
+          b = b * ba / 255 + src[0];
+
+          *dst = ( r << 16 ) | ( g << 8 ) | b;
+        }
+      }
+    }
+  }
+
+
+  static int
+  test_color_load( btimer_t*  timer,
+                   FT_Face    face,
+                   void*      user_data )
+  {
+    bcolor_t*     color = (bcolor_t*)user_data;
+    unsigned int  i;
+    int           done  = 0;
+
+
+    TIMER_START( timer );
+
+    FOREACH( i )
+    {
+      if ( !FT_Load_Glyph( face, i, color->flags ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  /* the layer loop of ftview's `Render_All' */
+  static int
+  test_color_layers( btimer_t*  timer,
+                     FT_Face    face,
+                     void*      user_data )
+  {
+    bcolor_t*     color = (bcolor_t*)user_data;
+    FT_Int32      flags;
+    unsigned int  i;
+    int           done  = 0;
+
+
+    flags  = load_flags & ~( FT_LOAD_COLOR | FT_LOAD_TARGET_( 0xF ) );
+    flags |= FT_LOAD_RENDER | FT_LOAD_TARGET_NORMAL;
+
+    TIMER_START( timer );
+
+    FOREACH( i )
+    {
+      FT_LayerIterator  iterator;
+      FT_UInt           layer_glyph_idx;
+      FT_UInt           layer_color_idx;
+      FT_Bitmap         bitmap;
+      FT_Vector         bitmap_offset = { 0, 0 };
+      FT_Error          error         = FT_Err_Ok;
+
+
+      iterator.p = NULL;
+      if ( !FT_Get_Color_Glyph_Layer( face,
+                                      i,
+                                      &layer_glyph_idx,
+                                      &layer_color_idx,
+                                      &iterator ) )
+        continue;
+
+      FT_Bitmap_Init( &bitmap );
+
+      do
+      {
+        FT_GlyphSlot  slot = face->glyph;
+        FT_Vector     slot_offset;
+
+
+        error = FT_Load_Glyph( face, layer_glyph_idx, flags );
+        if ( error )
+          break;
+
+        slot_offset.x = slot->bitmap_left * 64;
+        slot_offset.y = slot->bitmap_top * 64;
+
+        error = FT_Bitmap_Blend( lib,
+                                 &slot->bitmap,
+                                 slot_offset,
+                                 &bitmap,
+                                 &bitmap_offset,
+                                 color->palette[layer_color_idx] );
+
+      } while ( !error && FT_Get_Color_Glyph_Layer( face,
+                                                    i,
+                                                    &layer_glyph_idx,
+                                                    &layer_color_idx,
+                                                    &iterator ) );
+
+      FT_Bitmap_Done( lib, &bitmap );
+
+      if ( !error )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  static int
+  test_color_blit( btimer_t*  timer,
+                   FT_Face    face,
+                   void*      user_data )
+  {
+    bcolor_t*     color = (bcolor_t*)user_data;
+    unsigned int  i;
+    int           done  = 0;
+
+
+    FOREACH( i )
+    {
+      if ( FT_Load_Glyph( face, i, color->flags | FT_LOAD_RENDER ) ||
+           face->glyph->bitmap.pixel_mode != FT_PIXEL_MODE_BGRA    )
+        continue;
+
+      TIMER_START( timer );
+      blit_bgra( &face->glyph->bitmap, color->surface );
+      TIMER_STOP( timer );
+
+      done++;
+    }
+
+    return done;
+  }
+
+
+  /*
+   * Signed distance fields
+   */
+
+#define SDF_SPREADS  5
+
+  static const FT_Int  sdf_spreads[SDF_SPREADS] = { 2, 4, 8, 16, 32 };
+
+  enum {
+    SDF_OUTLINE,     /* `sdf' renderer */
+    SDF_OVERLAPS,    /* `sdf' renderer with property `overlaps' set */
+    SDF_BITMAP,      /* `bsdf' renderer on an anti-aliased bitmap */
+    N_SDF
+  };
+
+  /* the cost grows with the spread, so the larger ones are skipped  */
+  /* after a single iteration took longer than option `-t'; set by   */
+  /* the main thread, so that the worker threads skip the same tests */
+  static int  sdf_num_spreads[N_SDF];
+
+
+  static const char*  sdf_names[N_SDF] =
+  {
+    "SDF",
+    "SDF overlaps",
+    "BSDF"
+  };
+
+  /* the results refer to the titles, so keep them constant */
+  static const char*  sdf_titles[N_SDF][SDF_SPREADS] =
+  {
+    { "SDF (spread 2)", "SDF (spread 4)", "SDF (spread 8)",
+      "SDF (spread 16)", "SDF (spread 32)" },
+    { "SDF overlaps (spread 2)", "SDF overlaps (spread 4)",
+      "SDF overlaps (spread 8)", "SDF overlaps (spread 16)",
+      "SDF overlaps (spread 32)" },
+    { "BSDF (spread 2)", "BSDF (spread 4)", "BSDF (spread 8)",
+      "BSDF (spread 16)", "BSDF (spread 32)" }
+  };
+
+
+  typedef struct  bsdf_t_
+  {
+    int     kind;
+    double  bytes;     /* of all generated distance fields */
+    double  fields;
+
+  } bsdf_t;
+
+
+  static int
+  test_sdf( btimer_t*  timer,
+            FT_Face    face,
+            void*      user_data )
+  {
+    bsdf_t*       sdf  = (bsdf_t*)user_data;
+    FT_GlyphSlot  slot = face->glyph;
+    unsigned int  i;
+    int           done = 0;
+
+
+    FOREACH( i )
+    {
+      FT_Error  error = FT_Err_Ok;
+
+
+      if ( FT_Load_Glyph( face, i, load_flags ) )
+        continue;
+
+      /* a bitmap in the glyph slot makes `FT_Render_Glyph' use `bsdf'; */
+      /* its rasterization is part of the cost of the distance field    */
+      TIMER_START( timer );
+      if ( sdf->kind == SDF_BITMAP )
+        error = FT_Render_Glyph( slot, FT_RENDER_MODE_NORMAL );
+      if ( !error )
+        error = FT_Render_Glyph( slot, FT_RENDER_MODE_SDF );
+      TIMER_STOP( timer );
+
+      if ( error )
+        continue;
+
+      sdf->bytes  += (double)slot->bitmap.rows *
+                     (double)abs( slot->bitmap.pitch );
+      sdf->fields += 1.0;
+      done++;
+    }
+
+    return done;
+  }
+
+
+  /*
+   * Kerning and advances
+   */
+
+  /* text with many of the usual kerning pairs, used for the glyph */
+  /* pairs if there is no text workload                            */
+  static const char  kerning_text[] =
+    "AVA Tavern, LTV Yacht: \"Wolf away,\" yelled Torvald. "
+    "You were to try PAW's yoghurt (Fly Vega) - P.T. Lawyer, L'Avenue. "
+    "The quick brown fox jumps over the lazy dog; 17.4% of 1,098 Yen. "
+    "Kyoto, Warsaw, Oxford, Tokyo, Venice, Reykjavik, Lyon & Fjord.";
+
+
+  typedef struct  bkerning_t_
+  {
+    FT_UInt*  glyphs;     /* pair k is `glyphs[k]', `glyphs[k + 1]' */
+    int       num_glyphs;
+    FT_UInt   mode;       /* `FT_KERNING_XXX' */
+    FT_Int32  flags;      /* for the advances */
+
+  } bkerning_t;
+
+
+  static int
+  test_kerning( btimer_t*  timer,
+                FT_Face    face,
+                void*      user_data )
+  {
+    bkerning_t*  kern = (bkerning_t*)user_data;
+    FT_Vector    delta;
+    int          k;
+    int          done = 0;
+
+
+    TIMER_START( timer );
+
+    for ( k = 0; k + 1 < kern->num_glyphs; k++ )
+    {
+      if ( !FT_Get_Kerning( face,
+                            kern->glyphs[k],
+                            kern->glyphs[k + 1],
+                            kern->mode,
+                            &delta ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  static int
+  test_track_kerning( btimer_t*  timer,
+                      FT_Face    face,
+                      void*      user_data )
+  {
+    bkerning_t*  kern = (bkerning_t*)user_data;
+    FT_Fixed     point_size;
+    FT_Fixed     kerning;
+    int          k;
+    int          done = 0;
+
+
+    point_size = (FT_Fixed)face_size << 16;
+
+    TIMER_START( timer );
+
+    /* one call per pair, as a layout engine would do it; */
+    /* cycle through the degrees of tightness             */
+    for ( k = 0; k + 1 < kern->num_glyphs; k++ )
+    {
+      if ( !FT_Get_Track_Kerning( face,
+                                  point_size,
+                                  k % 3 - 1,
+                                  &kerning ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  static int
+  test_advance( btimer_t*  timer,
+                FT_Face    face,
+                void*      user_data )
+  {
+    bkerning_t*  kern = (bkerning_t*)user_data;
+    FT_Fixed     advance;
+    FT_UInt      i;
+    int          done = 0;
+
+
+    TIMER_START( timer );
+
+    FOREACH_INDEX( i )
+    {
+      if ( !FT_Get_Advance( face, i, kern->flags, &advance ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  static int
+  test_advances( btimer_t*  timer,
+                 FT_Face    face,
+                 void*      user_data )
+  {
+    bkerning_t*  kern = (bkerning_t*)user_data;
+    FT_Fixed*    advances;
+    FT_UInt      start, count;
+    int          done = 0;
+
+
+    if ( incr_index > 0 )
+    {
+      start = first_index;
+      count = last_index - first_index + 1;
+    }
+    else
+    {
+      start = last_index;
+      count = first_index - last_index + 1;
+    }
+
+    advances = (FT_Fixed*)calloc( sizeof ( FT_Fixed ), (size_t)count );
+    if ( !advances )
+      return 0;
+
+    TIMER_START( timer );
+
+    if ( !FT_Get_Advances( face, start, count, kern->flags, advances ) )
+      done = (int)count;
+
+    TIMER_STOP( timer );
+
+    free( advances );
+
+    return done;
+  }
+
+
+  /*
+   * Rasterizers
+   */
+
+  /* the glyph bitmaps are cleared in batches of about this size */
+  /* outside of the timing                                        */
+#define RASTER_BATCH  ( 1024 * 1024 )
+
+
+  typedef struct  boutline_t_
+  {
+    FT_Outline    outline;    /* moved to the origin of its bitmap */
+    unsigned int  width;
+    unsigned int  rows;
+
+  } boutline_t;
+
+
+  typedef struct  braster_t_
+  {
+    boutline_t*     glyphs;
+    int             num_glyphs;
+    unsigned char*  buffer;       /* for a batch of glyphs */
+    size_t          buffer_size;  /* at least the largest glyph */
+    int             mono;
+    int             direct;
+    unsigned long   coverage;     /* summed up by `raster_spans' */
+
+  } braster_t;
+
+
+  static void
+  raster_spans( int             y,
+                int             count,
+                const FT_Span*  spans,
+                void*           user )
+  {
+    braster_t*  raster = (braster_t*)user;
+
+    FT_UNUSED( y );
+
+
+    for ( ; count > 0; count--, spans++ )
+      raster->coverage += (unsigned long)spans->len * spans->coverage;
+  }
+
+
+  static int
+  test_raster( btimer_t*  timer,
+               FT_Face    face,
+               void*      user_data )
+  {
+    braster_t*        raster = (braster_t*)user_data;
+    FT_Raster_Params  params;
+    FT_Bitmap         bitmap;
+    int               k, first;
+    int               done = 0;
+
+    FT_UNUSED( face );
+
+
+    memset( &params, 0, sizeof ( params ) );
+    FT_Bitmap_Init( &bitmap );
+
+    params.flags = raster->mono ? 0 : FT_RASTER_FLAG_AA;
+    if ( raster->direct )
+    {
+      params.flags     |= FT_RASTER_FLAG_DIRECT;
+      params.gray_spans = raster_spans;
+      params.user       = raster;
+    }
+    else
+    {
+      params.target     = &bitmap;
+      bitmap.buffer     = raster->buffer;
+      bitmap.pixel_mode = raster->mono ? FT_PIXEL_MODE_MONO
+                                       : FT_PIXEL_MODE_GRAY;
+      bitmap.num_grays  = raster->mono ? 2 : 256;
+    }
+
+    if ( raster->direct )
+    {
+      TIMER_START( timer );
+
+      for ( k = 0; k < raster->num_glyphs; k++ )
+        if ( !FT_Outline_Render( lib, &raster->glyphs[k].outline, &params ) )
+          done++;
+
+      TIMER_STOP( timer );
+
+      return done;
+    }
+
+    /* every glyph of a batch gets its own part of the buffer, cleared */
+    /* before the timer starts, like the bitmaps the renderers use     */
+    for ( first = 0; first < raster->num_glyphs; first = k )
+    {
+      size_t  used = 0;
+      int     last;
+
+
+      for ( last = first; last < raster->num_glyphs; last++ )
+      {
+        boutline_t*  glyph = raster->glyphs + last;
+        size_t       size;
+
+
+        size = (size_t)( raster->mono ? ( glyph->width + 7 ) >> 3
+                                      : glyph->width ) * glyph->rows;
+        if ( used + size > raster->buffer_size )
+          break;
+        used += size;
+      }
+
+      memset( raster->buffer, 0, used );
+
+      bitmap.buffer = raster->buffer;
+
+      TIMER_START( timer );
+
+      for ( k = first; k < last; k++ )
+      {
+        boutline_t*  glyph = raster->glyphs + k;
+
+
+        bitmap.width = glyph->width;
+        bitmap.rows  = glyph->rows;
+        bitmap.pitch = raster->mono ? (int)( ( glyph->width + 7 ) >> 3 )
+                                    : (int)glyph->width;
+
+        if ( !FT_Outline_Render( lib, &glyph->outline, &params ) )
+          done++;
+
+        bitmap.buffer += (size_t)bitmap.pitch * bitmap.rows;
+      }
+
+      TIMER_STOP( timer );
+    }
+
+    return done;
+  }
+
+
+  /*
+   * Outline processing
+   */
+
+  /* the defaults of ftview's `Render_Stroke' and `Render_Fancy', */
+  /* relative to the ppem size                                     */
+#define OUTLINE_RADIUS  0.02
+#define OUTLINE_SLANT   0.22
+
+  typedef struct  bglyphs_t_
+  {
+    FT_Glyph*   glyphs;       /* outline glyphs, loaded up front */
+    int         num_glyphs;
+    FT_Stroker  stroker;
+    FT_Pos      strength;     /* for `FT_Outline_EmboldenXY' */
+    int         flip;         /* to undo every other transformation */
+
+  } bglyphs_t;
+
+
+  static int
+  outline_move_to( const FT_Vector*  to,
+                   void*             user )
+  {
+    FT_UNUSED( to );
+    FT_UNUSED( user );
+
+    return 0;
+  }
+
+
+  static int
+  outline_line_to( const FT_Vector*  to,
+                   void*             user )
+  {
+    FT_UNUSED( to );
+    FT_UNUSED( user );
+
+    return 0;
+  }
+
+
+  static int
+  outline_conic_to( const FT_Vector*  control,
+                    const FT_Vector*  to,
+                    void*             user )
+  {
+    FT_UNUSED( control );
+    FT_UNUSED( to );
+    FT_UNUSED( user );
+
+    return 0;
+  }
+
+
+  static int
+  outline_cubic_to( const FT_Vector*  control1,
+                    const FT_Vector*  control2,
+                    const FT_Vector*  to,
+                    void*             user )
+  {
+    FT_UNUSED( control1 );
+    FT_UNUSED( control2 );
+    FT_UNUSED( to );
+    FT_UNUSED( user );
+
+    return 0;
+  }
+
+
+  static const FT_Outline_Funcs  outline_funcs =
+  {
+    outline_move_to,
+    outline_line_to,
+    outline_conic_to,
+    outline_cubic_to,
+    0,
+    0
+  };
+
+
+  static int
+  test_decompose( btimer_t*  timer,
+                  FT_Face    face,
+                  void*      user_data )
+  {
+    bglyphs_t*  gl   = (bglyphs_t*)user_data;
+    int         k;
+    int         done = 0;
+
+    FT_UNUSED( face );
+
+
+    TIMER_START( timer );
+
+    for ( k = 0; k < gl->num_glyphs; k++ )
+    {
+      FT_OutlineGlyph  glyph = (FT_OutlineGlyph)gl->glyphs[k];
+
+
+      if ( !FT_Outline_Decompose( &glyph->outline, &outline_funcs, NULL ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  /* slant like `Render_Fancy', and straighten up again the next time */
+  static int
+  test_transform( btimer_t*  timer,
+                  FT_Face    face,
+                  void*      user_data )
+  {
+    bglyphs_t*  gl = (bglyphs_t*)user_data;
+    FT_Matrix   shear;
+    int         k;
+    int         done = 0;
+
+    FT_UNUSED( face );
+
+
+    shear.xx = 1 << 16;
+    shear.xy = (FT_Fixed)( ( gl->flip ? -OUTLINE_SLANT : OUTLINE_SLANT ) *
+                           ( 1 << 16 ) );
+    shear.yx = 0;
+    shear.yy = 1 << 16;
+
+    gl->flip = !gl->flip;
+
+    TIMER_START( timer );
+
+    for ( k = 0; k < gl->num_glyphs; k++ )
+    {
+      FT_OutlineGlyph  glyph = (FT_OutlineGlyph)gl->glyphs[k];
+
+
+      FT_Outline_Transform( &glyph->outline, &shear );
+      done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  static int
+  test_translate( btimer_t*  timer,
+                  FT_Face    face,
+                  void*      user_data )
+  {
+    bglyphs_t*  gl    = (bglyphs_t*)user_data;
+    FT_Pos      delta = gl->flip ? -32 : 32;
+    int         k;
+    int         done  = 0;
+
+    FT_UNUSED( face );
+
+
+    gl->flip = !gl->flip;
+
+    TIMER_START( timer );
+
+    for ( k = 0; k < gl->num_glyphs; k++ )
+    {
+      FT_OutlineGlyph  glyph = (FT_OutlineGlyph)gl->glyphs[k];
+
+
+      FT_Outline_Translate( &glyph->outline, delta, delta );
+      done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  /* the remaining tests modify a copy of every glyph */
+
+  static int
+  test_embolden_xy( btimer_t*  timer,
+                    FT_Face    face,
+                    void*      user_data )
+  {
+    bglyphs_t*  gl = (bglyphs_t*)user_data;
+    FT_Glyph    glyph;
+    int         k;
+    int         done = 0;
+
+    FT_UNUSED( face );
+
+
+    for ( k = 0; k < gl->num_glyphs; k++ )
+    {
+      if ( FT_Glyph_Copy( gl->glyphs[k], &glyph ) )
+        continue;
+
+      TIMER_START( timer );
+      if ( !FT_Outline_EmboldenXY( &( (FT_OutlineGlyph)glyph )->outline,
+                                   gl->strength,
+                                   gl->strength ) )
+        done++;
+      TIMER_STOP( timer );
+
+      FT_Done_Glyph( glyph );
+    }
+
+    return done;
+  }
+
+
+  static int
+  test_stroke_glyph( btimer_t*  timer,
+                     FT_Face    face,
+                     void*      user_data )
+  {
+    bglyphs_t*  gl = (bglyphs_t*)user_data;
+    FT_Glyph    glyph;
+    int         k;
+    int         done = 0;
+
+    FT_UNUSED( face );
+
+
+    for ( k = 0; k < gl->num_glyphs; k++ )
+    {
+      if ( FT_Glyph_Copy( gl->glyphs[k], &glyph ) )
+        continue;
+
+      TIMER_START( timer );
+      if ( !FT_Glyph_Stroke( &glyph, gl->stroker, 1 ) )
+        done++;
+      TIMER_STOP( timer );
+
+      FT_Done_Glyph( glyph );
+    }
+
+    return done;
+  }
+
+
+  static int
+  test_stroke_border( btimer_t*  timer,
+                      FT_Face    face,
+                      void*      user_data )
+  {
+    bglyphs_t*  gl = (bglyphs_t*)user_data;
+    FT_Glyph    glyph;
+    int         k;
+    int         done = 0;
+
+    FT_UNUSED( face );
+
+
+    for ( k = 0; k < gl->num_glyphs; k++ )
+    {
+      if ( FT_Glyph_Copy( gl->glyphs[k], &glyph ) )
+        continue;
+
+      TIMER_START( timer );
+      if ( !FT_Glyph_StrokeBorder( &glyph, gl->stroker, 0, 1 ) )
+        done++;
+      TIMER_STOP( timer );
+
+      FT_Done_Glyph( glyph );
+    }
+
+    return done;
+  }
+
+
+  /* only the first half of `FT_Glyph_Stroke', without the export */
+  static int
+  test_parse_outline( btimer_t*  timer,
+                      FT_Face    face,
+                      void*      user_data )
+  {
+    bglyphs_t*  gl   = (bglyphs_t*)user_data;
+    int         k;
+    int         done = 0;
+
+    FT_UNUSED( face );
+
+
+    TIMER_START( timer );
+
+    for ( k = 0; k < gl->num_glyphs; k++ )
+    {
+      FT_OutlineGlyph  glyph = (FT_OutlineGlyph)gl->glyphs[k];
+
+
+      if ( !FT_Stroker_ParseOutline( gl->stroker, &glyph->outline, 0 ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  /*
+   * Bitmap processing: the steps of the demo pipeline after the glyph
+   * cache, that is, `FTDemo_Glyph_To_Bitmap' and `FTDemo_Index_To_Bitmap'
+   */
+
+  typedef struct  bbitmaps_t_
+  {
+    FT_Glyph*       glyphs;       /* outline glyphs, loaded up front */
+    FT_Glyph*       rendered;     /* the same as gray bitmap glyphs */
+    FT_Bitmap*      monos;        /* the sources of `FT_Bitmap_Convert' */
+    FT_Bitmap*      grays2;
+    FT_Bitmap*      grays4;
+    FT_Bitmap*      copies;       /* of `rendered', to embolden */
+    int             num_glyphs;
+
+    FT_Render_Mode  render_mode;  /* for `FT_Glyph_To_Bitmap' */
+    FT_Bitmap*      sources;      /* for `FT_Bitmap_Convert' */
+    FT_Int          alignment;
+    FT_Pos          strength;     /* for `FT_Bitmap_Embolden' */
+
+    FT_Bitmap       target;       /* reused like the demos do */
+    FT_Vector       target_offset;
+    int             new_target;   /* blend into an empty target */
+
+  } bbitmaps_t;
+
+
+  static int
+  test_glyph_to_bitmap( btimer_t*  timer,
+                        FT_Face    face,
+                        void*      user_data )
+  {
+    bbitmaps_t*  bb   = (bbitmaps_t*)user_data;
+    int          k;
+    int          done = 0;
+
+    FT_UNUSED( face );
+
+
+    TIMER_START( timer );
+
+    for ( k = 0; k < bb->num_glyphs; k++ )
+    {
+      FT_Glyph  glyph = bb->glyphs[k];
+
+
+      /* don't destroy the original, like `FTDemo_Glyph_To_Bitmap' */
+      if ( !FT_Glyph_To_Bitmap( &glyph, bb->render_mode, NULL, 0 ) )
+      {
+        FT_Done_Glyph( glyph );
+        done++;
+      }
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  static int
+  test_bitmap_convert( btimer_t*  timer,
+                       FT_Face    face,
+                       void*      user_data )
+  {
+    bbitmaps_t*  bb   = (bbitmaps_t*)user_data;
+    int          k;
+    int          done = 0;
+
+    FT_UNUSED( face );
+
+
+    TIMER_START( timer );
+
+    for ( k = 0; k < bb->num_glyphs; k++ )
+    {
+      if ( !FT_Bitmap_Convert( lib,
+                               &bb->sources[k],
+                               &bb->target,
+                               bb->alignment ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  static int
+  test_bitmap_copy( btimer_t*  timer,
+                    FT_Face    face,
+                    void*      user_data )
+  {
+    bbitmaps_t*  bb   = (bbitmaps_t*)user_data;
+    int          k;
+    int          done = 0;
+
+    FT_UNUSED( face );
+
+
+    TIMER_START( timer );
+
+    for ( k = 0; k < bb->num_glyphs; k++ )
+    {
+      FT_BitmapGlyph  glyph = (FT_BitmapGlyph)bb->rendered[k];
+
+
+      if ( !FT_Bitmap_Copy( lib, &glyph->bitmap, &bb->target ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  /* emboldening works in place, so it needs a fresh copy like in */
+  /* ftview, which is made outside of the timing                    */
+  static int
+  test_bitmap_embolden( btimer_t*  timer,
+                        FT_Face    face,
+                        void*      user_data )
+  {
+    bbitmaps_t*  bb   = (bbitmaps_t*)user_data;
+    int          k;
+    int          done = 0;
+
+    FT_UNUSED( face );
+
+
+    for ( k = 0; k < bb->num_glyphs; k++ )
+    {
+      FT_BitmapGlyph  glyph = (FT_BitmapGlyph)bb->rendered[k];
+
+
+      FT_Bitmap_Copy( lib, &glyph->bitmap, &bb->copies[k] );
+    }
+
+    TIMER_START( timer );
+
+    for ( k = 0; k < bb->num_glyphs; k++ )
+    {
+      if ( !FT_Bitmap_Embolden( lib,
+                                &bb->copies[k],
+                                bb->strength,
+                                bb->strength ) )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  static int
+  test_bitmap_blend( btimer_t*  timer,
+                     FT_Face    face,
+                     void*      user_data )
+  {
+    bbitmaps_t*  bb    = (bbitmaps_t*)user_data;
+    FT_Color     black = { 0, 0, 0, 255 };
+    int          k;
+    int          done  = 0;
+
+    FT_UNUSED( face );
+
+
+    TIMER_START( timer );
+
+    for ( k = 0; k < bb->num_glyphs; k++ )
+    {
+      FT_BitmapGlyph  glyph = (FT_BitmapGlyph)bb->rendered[k];
+      FT_Vector       offset;
+      FT_Error        error;
+
+
+      offset.x = glyph->left * 64;
+      offset.y = glyph->top * 64;
+
+      if ( bb->new_target )
+      {
+        FT_Bitmap  target;
+        FT_Vector  target_offset = { 0, 0 };
+
+
+        FT_Bitmap_Init( &target );
+        error = FT_Bitmap_Blend( lib,
+                                 &glyph->bitmap,
+                                 offset,
+                                 &target,
+                                 &target_offset,
+                                 black );
+        FT_Bitmap_Done( lib, &target );
+      }
+      else
+        error = FT_Bitmap_Blend( lib,
+                                 &glyph->bitmap,
+                                 offset,
+                                 &bb->target,
+                                 &bb->target_offset,
+                                 black );
+
+      if ( !error )
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    return done;
+  }
+
+
+  /* pack an 8-bit gray bitmap into 2 or 4 bits per pixel, the format */
+  /* of GRAY2 and GRAY4 sbits                                         */
+  static void
+  pack_gray( const FT_Bitmap*  source,
+             FT_Bitmap*        target,
+             int               bits )
+  {
+    int            per_byte = 8 / bits;
+    unsigned int   x, y;
+
+
+    FT_Bitmap_Init( target );
+
+    target->rows       = source->rows;
+    target->width      = source->width;
+    target->pitch      = (int)( source->width + per_byte - 1 ) / per_byte;
+    target->num_grays  = (unsigned short)( 1 << bits );
+    target->pixel_mode = bits == 2 ? FT_PIXEL_MODE_GRAY2
+                                   : FT_PIXEL_MODE_GRAY4;
+    target->buffer     = (unsigned char*)calloc(
+                           (size_t)target->pitch * target->rows + 1, 1 );
+    if ( !target->buffer )
+    {
+      target->rows  = 0;
+      target->width = 0;
+      target->pitch = 0;
+
+      return;
+    }
+
+    for ( y = 0; y < source->rows; y++ )
+    {
+      const unsigned char*  s = source->buffer + (int)y * source->pitch;
+      unsigned char*        t = target->buffer + (int)y * target->pitch;
+
+
+      /* the leftmost pixel goes into the most significant bits */
+      for ( x = 0; x < source->width; x++ )
+        t[x / per_byte] |= (unsigned char)
+                             ( ( s[x] >> ( 8 - bits ) ) <<
+                               ( 8 - bits * (int)( x % per_byte + 1 ) ) );
+    }
+  }
+
+
+  /*
+   * Per-glyph latency profile
+   */
+
+  enum {
+    PROFILE_LOAD,
+    PROFILE_RENDER,
+    PROFILE_STROKE,
+    PROFILE_BBOX,
+    N_PROFILE
+  };
+
+
+  static const char*  profile_titles[N_PROFILE] =
+  {
+    "Load (per glyph)",
+    "Render (per glyph)",
+    "Stroke (per glyph)",
+    "Get_BBox (per glyph)"
+  };
+
+
+  typedef struct  bglyph_time_t_
+  {
+    unsigned int  gindex;
+    double        time;
+
+  } bglyph_time_t;
+
+
+  static int
+  compare_glyph_times( const void*  a,
+                       const void*  b )
+  {
+    double  x = ( (const bglyph_time_t*)a )->time;
+    double  y = ( (const bglyph_time_t*)b )->time;
+
+
+    return x < y ? 1 : x > y ? -1 : 0;
+  }
+
+
+  /* Time operation `op' once for glyph `gindex'; */
+  /* return a negative value on error.            */
+  static double
+  time_glyph( FT_Face       face,
+              FT_Stroker    stroker,
+              int           op,
+              unsigned int  gindex )
+  {
+    btimer_t  timer;
+    FT_Glyph  glyph;
+    FT_BBox   bbox;
+    FT_Error  error;
+
+
+    TIMER_RESET( &timer );
+
+    if ( op == PROFILE_LOAD )
+    {
+      TIMER_START( &timer );
+      error = FT_Load_Glyph( face, gindex, load_flags );
+      TIMER_STOP( &timer );
+
+      return error ? -1.0 : TIMER_GET( &timer );
+    }
+
+    if ( FT_Load_Glyph( face, gindex, load_flags ) )
+      return -1.0;
+
+    switch ( op )
+    {
+    case PROFILE_RENDER:
+      TIMER_START( &timer );
+      error = FT_Render_Glyph( face->glyph, render_mode );
+      TIMER_STOP( &timer );
+      break;
+
+    case PROFILE_STROKE:
+      if ( FT_Get_Glyph( face->glyph, &glyph ) )
+        return -1.0;
+
+      TIMER_START( &timer );
+      error = FT_Glyph_Stroke( &glyph, stroker, 1 );
+      TIMER_STOP( &timer );
+
+      FT_Done_Glyph( glyph );
+      break;
+
+    default: /* PROFILE_BBOX */
+      if ( face->glyph->format != FT_GLYPH_FORMAT_OUTLINE )
+        return -1.0;
+
+      TIMER_START( &timer );
+      error = FT_Outline_Get_BBox( &face->glyph->outline, &bbox );
+      TIMER_STOP( &timer );
+      break;
+    }
+
+    return error ? -1.0 : TIMER_GET( &timer );
+  }
+
+
+  static void
+  profile_glyphs( FT_Face  face )
+  {
+    bglyph_time_t*  times;
+    FT_Stroker      stroker;
+    size_t          max_glyphs;
+    int             op;
+
+
+    max_glyphs = ( incr_index > 0 ? last_index - first_index
+                                  : first_index - last_index ) + 1;
+
+    times = (bglyph_time_t*)malloc( max_glyphs * sizeof ( bglyph_time_t ) );
+    if ( !times )
+      return;
+
+    FT_Stroker_New( lib, &stroker );
+    FT_Stroker_Set( stroker, face->size->metrics.y_ppem,
+                    FT_STROKER_LINECAP_ROUND,
+                    FT_STROKER_LINEJOIN_ROUND,
+                    0 );
+
+    printf( "\n"
+            "per-glyph latencies (median of %d runs per glyph):\n",
+            PROFILE_REPEAT );
+
+    for ( op = 0; op < N_PROFILE; op++ )
+    {
+      bresult_t*    result;
+      double*       samples;
+      unsigned int  i;
+      int           count = 0, k;
+      int           histogram[PROFILE_BUCKETS];
+
+
+      if ( !face_size && op != PROFILE_LOAD && op != PROFILE_BBOX )
+      {
+        printf( "\n  %-25s disabled (size = 0)\n", profile_titles[op] );
+        continue;
+      }
+
+      FOREACH_INDEX( i )
+      {
+        double  t[PROFILE_REPEAT];
+        int     r;
+
+
+        for ( r = 0; r < PROFILE_REPEAT; r++ )
+        {
+          t[r] = time_glyph( face, stroker, op, i );
+          if ( t[r] < 0 )
+            break;
+        }
+
+        if ( r < PROFILE_REPEAT )
+          continue;
+
+        qsort( t, PROFILE_REPEAT, sizeof ( double ), compare_doubles );
+
+        times[count].gindex = i;
+        times[count].time   = t[PROFILE_REPEAT / 2];
+        count++;
+      }
+
+      printf( "\n  %-25s ", profile_titles[op] );
+
+      if ( !count )
+      {
+        printf( "no error-free calls\n" );
+        continue;
+      }
+
+      samples = (double*)malloc( (size_t)count * sizeof ( double ) );
+      if ( !samples )
+        break;
+
+      for ( k = 0; k < count; k++ )
+        samples[k] = times[k].time;
+
+      result = add_result( profile_titles[op] );
+      if ( result )
+      {
+        result->done       = count;
+        result->iterations = PROFILE_REPEAT;
+        result->samples    = samples;
+
+        for ( k = 0; k < count; k++ )
+          result->total += samples[k];
+
+        compute_stats( samples, count, &result->stats );
+
+        printf( "median %.3f us, p99 %.3f us, %d glyphs\n",
+                result->stats.median, result->stats.p99, count );
+      }
+      else
+        free( samples );
+
+      /* logarithmic histogram, each bucket doubling the upper limit */
+      memset( histogram, 0, sizeof ( histogram ) );
+      for ( k = 0; k < count; k++ )
+      {
+        double  limit = 0.125;
+        int     b     = 0;
+
+
+        while ( b < PROFILE_BUCKETS - 1 && times[k].time >= limit )
+        {
+          limit *= 2;
+          b++;
+        }
+        histogram[b]++;
+      }
+
+      for ( k = 0; k < PROFILE_BUCKETS; k++ )
+      {
+        int  bar;
+
+
+        if ( !histogram[k] )
+          continue;
+
+        if ( k == PROFILE_BUCKETS - 1 )
+          printf( "    %9s >= %8.3f us %7d ", "",
+                  0.125 * ( 1 << ( k - 1 ) ), histogram[k] );
+        else
+          printf( "    %9.3f .. %8.3f us %7d ",
+                  k ? 0.125 * ( 1 << ( k - 1 ) ) : 0.0,
+                  0.125 * ( 1 << k ),
+                  histogram[k] );
+
+        for ( bar = 0; bar < ( 40 * histogram[k] + count - 1 ) / count; bar++ )
+          putchar( '#' );
+        putchar( '\n' );
+      }
+
+      /* slowest glyphs */
+      qsort( times, (size_t)count, sizeof ( bglyph_time_t ),
+             compare_glyph_times );
+
+      printf( "    slowest glyphs:\n" );
+      for ( k = 0; k < count && k < profile_top; k++ )
+        printf( "      glyph %5u %10.3f us %8.1fx median\n",
+                times[k].gindex,
+                times[k].time,
+                result && result->stats.median > 0
+                  ? times[k].time / result->stats.median
+                  : 0.0 );
+    }
+
+    FT_Stroker_Done( stroker );
+    free( times );
+  }
+
+
+  /*
+   * main
+   */
+
+  static void
+  get_charset( FT_Face      face,
+               bcharset_t*  charset )
+  {
+    FT_ULong  charcode;
+    FT_UInt   gindex;
+    int       i = 0;
+
+
+    /* a text workload replaces the charmap order */
+    if ( workload_chars )
+    {
+      charset->code = (FT_ULong*)malloc( (size_t)num_workload_chars *
+                                           sizeof ( FT_ULong ) );
+      if ( !charset->code )
+        return;
+
+      memcpy( charset->code,
+              workload_chars,
+              (size_t)num_workload_chars * sizeof ( FT_ULong ) );
+      charset->size = num_workload_chars;
+
+      return;
+    }
+
+    charset->code = (FT_ULong*)calloc( (size_t)face->num_glyphs,
+                                       sizeof ( FT_ULong ) );
+    if ( !charset->code )
+      return;
+
+    if ( face->charmap )
+    {
+      charcode = FT_Get_First_Char( face, &gindex );
+
+      /* certain fonts contain a broken charmap that will map character */
+      /* codes to out-of-bounds glyph indices.  Take care of that here. */
+      /*                                                                */
+      while ( gindex && i < face->num_glyphs )
+      {
+        if ( ( first_index <= gindex && gindex <= last_index ) ||
+             ( first_index >= gindex && gindex >= last_index ) )
+          charset->code[i++] = charcode;
+        charcode = FT_Get_Next_Char( face, charcode, &gindex );
+      }
+    }
+    else
+    {
+      unsigned int  j;
+
+
+      /* no charmap, do an identity mapping */
+      FOREACH_INDEX( j )
+        charset->code[i++] = j;
+    }
+
+    charset->size = i;
+  }
+
+
+  /* a font file read into memory or mapped */
+  typedef struct  bfile_t_
+  {
+    FT_Byte*  base;
+    size_t    size;
+    int       mapped;
+
+  } bfile_t;
+
+
+  static int
+  file_load( const char*  name,
+             int          map,
+             bfile_t*     file )
+  {
+    FILE*  fp;
+
+
+    file->base   = NULL;
+    file->size   = 0;
+    file->mapped = 0;
+
+#ifdef UNIX
+    if ( map )
+    {
+      struct stat  st;
+      void*        base = MAP_FAILED;
+      int          fd   = open( name, O_RDONLY );
+
+
+      if ( fd < 0 )
+      {
+        fprintf( stderr, "couldn't find or open `%s'\n", name );
+
+        return 1;
+      }
+
+      if ( !fstat( fd, &st ) && st.st_size > 0 )
+        base = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+                     fd, 0 );
+      close( fd );
+
+      if ( base == MAP_FAILED )
+      {
+        fprintf( stderr, "couldn't map `%s'\n", name );
+
+        return 1;
+      }
+
+      file->base   = (FT_Byte*)base;
+      file->size   = (size_t)st.st_size;
+      file->mapped = 1;
+
+      return 0;
+    }
+#else
+    FT_UNUSED( map );
+#endif
+
+    fp = fopen( name, "rb" );
+    if ( fp == NULL )
+    {
+      fprintf( stderr, "couldn't find or open `%s'\n", name );
+
+      return 1;
+    }
+
+    fseek( fp, 0, SEEK_END );
+    file->size = (size_t)ftell( fp );
+    fseek( fp, 0, SEEK_SET );
+
+    file->base = (FT_Byte*)malloc( file->size );
+    if ( file->base == NULL )
+    {
+      fprintf( stderr,
+               "couldn't allocate memory to pre-load font file\n" );
+      fclose( fp );
+
+      return 1;
+    }
+
+    if ( !fread( file->base, file->size, 1, fp ) )
+    {
+      fprintf( stderr, "read error\n" );
+      free( file->base );
+      file->base = NULL;
+      fclose( fp );
+
+      return 1;
+    }
+
+    fclose( fp );
+
+    return 0;
+  }
+
+
+  static void
+  file_unload( bfile_t*  file )
+  {
+#ifdef UNIX
+    if ( file->mapped )
+      munmap( file->base, file->size );
+    else
+#endif
+      free( file->base );
+
+    file->base = NULL;
+  }
+
+
+  /*
+   * Slow-I/O stream (option `-O'): the font file is read through a custom
+   * `FT_Stream' that fetches it in chunks and spins for a fixed latency
+   * per fetch, like a face backed by a compressed or remote blob store
+   */
+
+  enum
+  {
+    STREAM_OPEN,      /* `FT_Open_Face' */
+    STREAM_LOAD,      /* first pass of `FT_Load_Glyph' */
+    STREAM_RELOAD,    /* second pass */
+    N_STREAM_PHASES
+  };
+
+  static const char*  stream_phases[N_STREAM_PHASES] =
+  {
+    "open",
+    "load",
+    "load again"
+  };
+
+
+  typedef struct  bstreamstats_t_
+  {
+    unsigned long  reads;       /* calls of `read' with data */
+    unsigned long  seeks;       /* calls of `read' without data */
+    double         bytes;       /* requested by FreeType */
+    unsigned long  fetches;     /* reads from the backing store */
+    double         fetched;     /* bytes fetched */
+    double         distance;    /* sum of the seek distances */
+
+  } bstreamstats_t;
+
+
+  /* an sfnt table to attribute reads to */
+  typedef struct  bstreamtable_t_
+  {
+    FT_ULong  tag;
+    FT_ULong  offset;
+    FT_ULong  length;
+    double    bytes[N_STREAM_PHASES];
+
+  } bstreamtable_t;
+
+
+  typedef struct  bstream_t_
+  {
+    FT_StreamRec     stream;
+    FILE*            file;
+    unsigned long    pos;         /* where the last access ended */
+
+    unsigned char*   chunk;       /* the last chunk fetched */
+    unsigned long    chunk_pos;   /* its offset, or ~0 */
+    unsigned long    chunk_len;
+
+    int              phase;
+    bstreamstats_t   stats[N_STREAM_PHASES];
+    bstreamtable_t*  tables;      /* optional */
+    FT_UInt          num_tables;
+
+  } bstream_t;
+
+
+  static void
+  stream_wait( void )
+  {
+    double  t0;
+
+
+    if ( !stream_latency )
+      return;
+
+    t0 = get_time();
+    while ( get_time() - t0 < stream_latency )
+      ;
+  }
+
+
+  static unsigned long
+  stream_fetch( bstream_t*      bs,
+                unsigned long   offset,
+                unsigned char*  buffer,
+                unsigned long   count )
+  {
+    bstreamstats_t*  stats = bs->stats + bs->phase;
+    size_t           got;
+
+
+    stream_wait();
+
+    if ( fseek( bs->file, (long)offset, SEEK_SET ) )
+      return 0;
+    got = fread( buffer, 1, count, bs->file );
+
+    stats->fetches++;
+    stats->fetched += got;
+
+    return (unsigned long)got;
+  }
+
+
+  static unsigned long
+  stream_read( FT_Stream       stream,
+               unsigned long   offset,
+               unsigned char*  buffer,
+               unsigned long   count )
+  {
+    bstream_t*       bs    = (bstream_t*)stream->descriptor.pointer;
+    bstreamstats_t*  stats = bs->stats + bs->phase;
+    unsigned long    done  = 0;
+    FT_UInt          k;
+
+
+    stats->distance += offset > bs->pos ? offset - bs->pos
+                                        : bs->pos - offset;
+
+    /* a seek */
+    if ( !count )
+    {
+      stats->seeks++;
+      bs->pos = offset;
+
+      return offset > stream->size;
+    }
+
+    if ( offset >= stream->size )
+      return 0;
+    if ( count > stream->size - offset )
+      count = stream->size - offset;
+
+    stats->reads++;
+    stats->bytes += count;
+
+    for ( k = 0; k < bs->num_tables; k++ )
+    {
+      bstreamtable_t*  table = bs->tables + k;
+      unsigned long    start = offset;
+      unsigned long    end   = offset + count;
+
+
+      if ( start < table->offset )
+        start = table->offset;
+      if ( end > table->offset + table->length )
+        end = table->offset + table->length;
+
+      if ( start < end )
+        table->bytes[bs->phase] += end - start;
+    }
+
+    if ( !stream_chunk )
+      done = stream_fetch( bs, offset, buffer, count );
+    else
+    {
+      while ( done < count )
+      {
+        unsigned long  pos = offset + done;
+        unsigned long  base = pos - pos % stream_chunk;
+        unsigned long  len;
+
+
+        if ( base != bs->chunk_pos )
+        {
+          bs->chunk_len = stream_fetch( bs, base, bs->chunk, stream_chunk );
+          bs->chunk_pos = base;
+        }
+
+        if ( pos - base >= bs->chunk_len )
+          break;
+
+        len = bs->chunk_len - ( pos - base );
+        if ( len > count - done )
+          len = count - done;
+        memcpy( buffer + done, bs->chunk + ( pos - base ), len );
+        done += len;
+      }
+    }
+
+    bs->pos = offset + done;
+
+    return done;
+  }
+
+
+  /* called by `FT_Done_Face' (or by `FT_Open_Face' on failure) */
+  static void
+  stream_close( FT_Stream  stream )
+  {
+    bstream_t*  bs = (bstream_t*)stream->descriptor.pointer;
+
+
+    fclose( bs->file );
+    free( bs->chunk );
+    free( bs->tables );
+    free( bs );
+  }
+
+
+  static FT_ULong
+  stream_get_ulong( const unsigned char*  p )
+  {
+    return ( (FT_ULong)p[0] << 24 ) | ( (FT_ULong)p[1] << 16 ) |
+           ( (FT_ULong)p[2] <<  8 ) |   (FT_ULong)p[3];
+  }
+
+
+  /* read the sfnt table directory of the face, bypassing the stream */
+  static FT_UInt
+  stream_get_tables( bstreamtable_t**  atables )
+  {
+    bstreamtable_t*  tables = NULL;
+    unsigned char    header[16];
+    FT_ULong         offset = 0;
+    FT_UInt          num_tables = 0;
+    FT_UInt          k;
+    FILE*            fp;
+
+
+    *atables = NULL;
+
+    fp = fopen( filename, "rb" );
+    if ( !fp )
+      return 0;
+
+    if ( fread( header, 1, 12, fp ) != 12 )
+      goto Exit;
+
+    /* the offset of the face in a collection */
+    if ( !memcmp( header, "ttcf", 4 ) )
+    {
+      FT_ULong  index = (FT_ULong)( face_index & 0xFFFF );
+
+
+      if ( index >= stream_get_ulong( header + 8 )          ||
+           fseek( fp, (long)( 12 + 4 * index ), SEEK_SET ) ||
+           fread( header, 1, 4, fp ) != 4                   )
+        goto Exit;
+
+      offset = stream_get_ulong( header );
+      if ( fseek( fp, (long)offset, SEEK_SET ) ||
+           fread( header, 1, 12, fp ) != 12    )
+        goto Exit;
+    }
+
+    if ( stream_get_ulong( header ) != 0x00010000UL &&
+         memcmp( header, "OTTO", 4 )                &&
+         memcmp( header, "true", 4 )                )
+      goto Exit;
+
+    num_tables = ( (FT_UInt)header[4] << 8 ) | header[5];
+    tables     = (bstreamtable_t*)calloc( num_tables ? num_tables : 1,
+                                          sizeof ( bstreamtable_t ) );
+    if ( !tables )
+    {
+      num_tables = 0;
+      goto Exit;
+    }
+
+    for ( k = 0; k < num_tables; k++ )
+    {
+      if ( fread( header, 1, 16, fp ) != 16 )
+        break;
+
+      tables[k].tag    = stream_get_ulong( header );
+      tables[k].offset = stream_get_ulong( header + 8 );
+      tables[k].length = stream_get_ulong( header + 12 );
+    }
+    num_tables = k;
+
+    *atables = tables;
+
+  Exit:
+    fclose( fp );
+
+    return num_tables;
+  }
+
+
+  /* open `filename' through a new stream; if `astream' is set, */
+  /* return the stream and attribute its reads to sfnt tables    */
+  static FT_Error
+  stream_open( FT_Face*     face,
+               bstream_t**  astream )
+  {
+    bstream_t*    bs;
+    FT_Open_Args  args;
+    long          size;
+
+
+    bs = (bstream_t*)calloc( 1, sizeof ( bstream_t ) );
+    if ( !bs )
+      return FT_Err_Out_Of_Memory;
+
+    bs->file = fopen( filename, "rb" );
+    if ( !bs->file )
+    {
+      free( bs );
+
+      return FT_Err_Cannot_Open_Resource;
+    }
+
+    fseek( bs->file, 0, SEEK_END );
+    size = ftell( bs->file );
+
+    if ( stream_chunk )
+    {
+      bs->chunk = (unsigned char*)malloc( stream_chunk );
+      if ( !bs->chunk )
+      {
+        fclose( bs->file );
+        free( bs );
+
+        return FT_Err_Out_Of_Memory;
+      }
+    }
+    bs->chunk_pos = ~0UL;
+
+    bs->stream.size               = size > 0 ? (unsigned long)size : 0;
+    bs->stream.descriptor.pointer = bs;
+    bs->stream.read               = stream_read;
+    bs->stream.close              = stream_close;
+
+    args.flags  = FT_OPEN_STREAM;
+    args.stream = &bs->stream;
+
+    if ( astream )
+    {
+      bs->num_tables = stream_get_tables( &bs->tables );
+      *astream       = bs;
+    }
+
+    /* the stream gets closed on failure, too */
+    return FT_Open_Face( lib, &args, face_index, face );
+  }
+
+
+  /* print the I/O of opening the face and loading all glyphs twice */
+  static void
+  run_stream_profile( void )
+  {
+    bstream_t*  bs;
+    FT_Face     face;
+    FT_UInt     k;
+    int         p;
+    double      times[N_STREAM_PHASES];
+    double      t0;
+    unsigned    i;
+
+
+    t0 = get_time();
+    if ( stream_open( &face, &bs ) )
+    {
+      printf( "\n"
+              "stream I/O: couldn't open the face\n" );
+      return;
+    }
+    times[STREAM_OPEN] = get_time() - t0;
+
+    set_face_size( face );
+
+    for ( p = STREAM_LOAD; p < N_STREAM_PHASES; p++ )
+    {
+      bs->phase = p;
+
+      t0 = get_time();
+      FOREACH( i )
+        FT_Load_Glyph( face, i, load_flags );
+      times[p] = get_time() - t0;
+    }
+
+    printf( "\n"
+            "stream I/O (latency %luus, ",
+            stream_latency );
+    if ( stream_chunk )
+      printf( "chunks of %lu bytes):\n", stream_chunk );
+    else
+      printf( "reads as requested):\n" );
+    printf( "\n"
+            "  %-10s %10s %8s %8s %10s %8s %10s %6s %10s\n",
+            "", "ms", "reads", "seeks", "KiB", "fetches", "KiB fetched",
+            "ampl.", "seek KiB" );
+
+    for ( p = 0; p < N_STREAM_PHASES; p++ )
+    {
+      bstreamstats_t*  stats = bs->stats + p;
+
+
+      printf( "  %-10s %10.3f %8lu %8lu %10.1f %8lu %10.1f %6.2f %10.1f\n",
+              stream_phases[p],
+              times[p] / 1000,
+              stats->reads,
+              stats->seeks,
+              stats->bytes / 1024,
+              stats->fetches,
+              stats->fetched / 1024,
+              stats->bytes > 0 ? stats->fetched / stats->bytes : 0.0,
+              stats->distance / 1024 );
+    }
+
+    if ( bs->num_tables )
+    {
+      printf( "\n"
+              "  %-10s %10s %10s %10s %10s\n",
+              "table", "KiB", "open KiB", "load KiB", "again KiB" );
+
+      for ( k = 0; k < bs->num_tables; k++ )
+      {
+        bstreamtable_t*  table = bs->tables + k;
+
+
+        printf( "  %c%c%c%c       %10.1f",
+                (char)( table->tag >> 24 ),
+                (char)( table->tag >> 16 ),
+                (char)( table->tag >> 8 ),
+                (char)( table->tag ),
+                (double)table->length / 1024 );
+
+        for ( p = 0; p < N_STREAM_PHASES; p++ )
+          printf( " %10.1f", table->bytes[p] / 1024 );
+        printf( "%s\n",
+                table->bytes[STREAM_OPEN] > 0 ||
+                table->bytes[STREAM_LOAD] > 0 ? "" : "  (untouched)" );
+      }
+    }
+
+    /* closes the stream */
+    FT_Done_Face( face );
+  }
+
+
+  static FT_Error
+  get_face( FT_Face*  face )
+  {
+    static bfile_t      memory_file;
+    static const char*  memory_name = NULL;
+    FT_Error            error;
+
+
+    if ( stream_mode )
+      error = stream_open( face, NULL );
+    else if ( preload )
+    {
+      /* in corpus mode, the preloaded file changes now and then */
+      if ( memory_file.base && memory_name != filename )
+        file_unload( &memory_file );
+
+      if ( !memory_file.base )
+      {
+        if ( file_load( filename, preload == 2, &memory_file ) )
+          return 1;
+
+        memory_name = filename;
+      }
+
+      error = FT_New_Memory_Face( lib,
+                                  memory_file.base,
+                                  (FT_Long)memory_file.size,
+                                  face_index,
+                                  face );
+    }
+    else
+      error = FT_New_Face( lib, filename, face_index, face );
+
+    if ( error )
+      fprintf( stderr, "couldn't load font resource\n");
+
+    return error;
+  }
+
+
+  static void
+  usage( void )
+  {
+    int   i;
+    char  interpreter_versions[32];
+    char  hinting_engines[32];
+
+
+    /* we expect that at least one interpreter version is available */
+    if ( num_tt_interpreter_versions == 2 )
+      snprintf( interpreter_versions, sizeof ( interpreter_versions ),
+                "%u and %u",
+                tt_interpreter_versions[0],
+                tt_interpreter_versions[1] );
+    else
+      snprintf( interpreter_versions, sizeof ( interpreter_versions ),
+                "%u, %u, and %u",
+                tt_interpreter_versions[0],
+                tt_interpreter_versions[1],
+                tt_interpreter_versions[2] );
+
+    /* we expect that at least one hinting engine is available */
+    if ( num_ps_hinting_engines == 1 )
+      snprintf( hinting_engines, sizeof ( hinting_engines ),
+                "`%s'",
+                ps_hinting_engine_names[ps_hinting_engines[0]] );
+    else
+      snprintf( hinting_engines, sizeof ( hinting_engines ),
+                "`%s' and `%s'",
+                ps_hinting_engine_names[ps_hinting_engines[0]],
+                ps_hinting_engine_names[ps_hinting_engines[1]] );
+
+
+    fprintf( stderr,
+      "\n"
+      "ftbench: run FreeType benchmarks\n"
+      "--------------------------------\n"
+      "\n"
+      "Usage: ftbench [options] fontname...\n"
+      "\n"
+      "  -a E      Adaptive mode: stop sampling a test as soon as the 95%%\n"
+      "            confidence interval is within E percent of the mean\n"
+      "            (still limited by options `-c' and `-t').\n"
+      "  -B FILE   Save the results as a baseline to FILE.\n"
+      "  -C        Compare with cached version (if available).\n"
+      "  -c N      Use at most N iterations for each test\n"
+      "            (0 means time limited).\n"
+      "  -D        Instead of the tests, time opening the face and the\n"
+      "            first cmap lookup, load, and render with the font file\n"
+      "            dropped from the page cache, using `FT_New_Face',\n"
+      "            preloading, and `mmap' (options `-p' and `-P' are\n"
+      "            ignored).\n"
+      "  -d        Report the distribution of the samples of each test\n"
+      "            (mean, median, standard deviation, percentiles, and\n"
+      "            95%% confidence interval of the mean).\n"
+      "  -E        Run the tests with every TrueType interpreter version\n"
+      "            or CFF/Type 1/CID hinting engine, the auto-hinter, and\n"
+      "            without hinting, and print a table of their costs.\n"
+      "  -e        Report hardware performance counters per operation\n"
+      "            (cycles, instructions, cache and branch misses).\n"
+      "  -f L      Use hex number L as load flags (see `FT_LOAD_XXX').\n"
+      "  -g N      Profile load, render, stroke, and bbox latencies\n"
+      "            per glyph; show a histogram and the N slowest glyphs.\n"
+      "  -H NAME   Use PS hinting engine NAME.\n"
+      "            Available versions are %s; default is `%s'.\n"
+      "  -I VER    Use TT interpreter version VER.\n"
+      "            Available versions are %s; default is version %u.\n"
+      "  -i I-J    Forward or reverse range of glyph indices to use\n"
+      "            (default is from 0 to the number of glyphs minus one).\n"
+      "  -j N      Also run the tests in N threads simultaneously, each\n"
+      "            with its own library, face, and caches, and report\n"
+      "            the scaling relative to the single-threaded run.\n"
+      "  -K FxS    Instead of the tests, sweep the face, size, and byte\n"
+      "            limits of the image, sbit, and cmap caches over a\n"
+      "            working set of F faces and S sizes (at most 16 each)\n"
+      "            and report the hit ratio of random lookups.\n"
+      "  -l N      Set LCD filter to N\n"
+      "              0: none, 1: default, 2: light, 16: legacy\n"
+      "  -L W,...  Set LCD filter weights to the five values W,...\n"
+      "  -M        Report allocations, reallocations, and allocated bytes\n"
+      "            per operation, and the peak of live bytes.\n"
+      "  -m M      Set maximum cache size to M KiByte (default is %d).\n"
+      "  -O L[,C]  Open the font through a custom stream that waits L\n"
+      "            microseconds per read and reads in chunks of C bytes\n"
+      "            (default is 0, the requested size); also print the\n"
+      "            I/O done for opening the face and loading glyphs.\n"
+      "  -o FILE   Also write the results to FILE, as CSV if its name\n"
+      "            ends with `.csv', as JSON otherwise.\n",
+             hinting_engines,
+             ps_hinting_engine_names[dflt_ps_hinting_engine],
+             interpreter_versions,
+             dflt_tt_interpreter_version,
+             CACHE_SIZE );
+    fprintf( stderr,
+      "  -p        Preload font file in memory.\n"
+      "  -P        Like `-p', but map the font file with `mmap'.\n"
+      "  -R FILE   Compare the results with baseline FILE and exit with\n"
+      "            status 2 if a test is significantly slower.\n"
+      "  -r N      Set render mode to N\n"
+      "              0: normal, 1: light, 2: mono, 3: LCD, 4: LCD vertical\n"
+      "            (default is 0).\n"
+      "  -s S      Use S ppem as face size (default is %dppem).\n"
+      "            If set to zero, don't call FT_Set_Pixel_Sizes.\n"
+      "            Use value 0 with option `-f 1' or something similar to\n"
+      "            load the glyphs unscaled, otherwise errors will show up.\n"
+      "  -S LIST   Run the tests for all ppem sizes in LIST, for example\n"
+      "            `8,12,16-72:8' (ranges use step 1 if none is given),\n"
+      "            and print a table of cost versus size.\n",
+             FACE_SIZE );
+    fprintf( stderr,
+      "  -T P      Regression threshold for `-R' in percent (default %.0f).\n"
+      "  -t T      Use at most T seconds per bench (default is %.0f).\n"
+      "  -U N      Instead of the tests, do the lookups of the image,\n"
+      "            sbit, and cmap cache tests in N threads sharing one\n"
+      "            locked cache, N locked caches selected by key, or\n"
+      "            using a cache each, and report throughput and memory.\n"
+      "  -w N      Run N untimed warm-up iterations before each test.\n"
+      "  -W FILE   Replay the UTF-8 text in FILE (or draw from the\n"
+      "            frequency table in FILE, with lines `U+XXXX count')\n"
+      "            in the cmap, cache, load, and render tests instead of\n"
+      "            iterating over all glyph indices.\n"
+      "  -X        Instead of the tests, time rendering and the sbit\n"
+      "            cache for each render mode with each LCD filter\n"
+      "            (`custom' uses the weights of option `-L') and print\n"
+      "            a table of cost versus mode and filter.\n"
+      "  -Y T      Run only test T and profile its timed sections by\n"
+      "            sampling the call stack, printing a flat profile.\n"
+      "  -y FILE   With `-Y', also write folded stacks to FILE.\n"
+      "  -Z S      Like `-W', but draw from a Zipf distribution with\n"
+      "            exponent S over the characters in charmap order.\n"
+      "\n"
+      "  -b tests  Perform chosen tests (default is `a' to `l';\n"
+      "            the others only run if chosen):\n",
+             regress_threshold,
+             BENCH_TIME );
+
+    for ( i = 0; i < N_FT_BENCH; i++ )
+    {
+      if ( !bench_desc[i] )
+        break;
+
+      fprintf( stderr,
+      "              %c  %s\n", 'a' + i, bench_desc[i] );
+    }
+
+    fprintf( stderr,
+      "\n"
+      "  -v        Show version.\n"
+      "\n"
+      "If more than one font file, a directory (searched recursively),\n"
+      "or a file list `@LIST' (one name per line) is given, run the tests\n"
+      "on all faces and named instances of all fonts and also report\n"
+      "results aggregated by font format.\n"
+      "\n" );
+
+    exit( 1 );
+  }
+
+
+  /* the tests after `l' only run if chosen with option `-b' */
+#define TEST( x ) ( test_string ? strchr( test_string, (x) ) != NULL  \
+                                : (x) < 'a' + N_FT_BENCH_DEFAULT )
+
+
+  /*
+   * Set up the library of the current thread with the chosen properties
+   */
+
+  static void
+  set_hinting_engines( FT_Library  library )
+  {
+    FT_Property_Set( library,
+                     "truetype",
+                     "interpreter-version", &tt_interpreter_version );
+    FT_Property_Set( library,
+                     "cff",
+                     "hinting-engine", &ps_hinting_engine );
+    FT_Property_Set( library,
+                     "type1",
+                     "hinting-engine", &ps_hinting_engine );
+    FT_Property_Set( library,
+                     "t1cid",
+                     "hinting-engine", &ps_hinting_engine );
+  }
+
+
+  /* like `FT_Init_FreeType', but with a counting memory manager */
+  static FT_Error
+  library_new( FT_Memory     memory,
+               bmemstats_t*  stats,
+               FT_Library*   alibrary )
+  {
+    FT_Error  error;
+
+
+    memset( stats, 0, sizeof ( *stats ) );
+
+    memory->user    = stats;
+    memory->alloc   = bench_alloc;
+    memory->free    = bench_free;
+    memory->realloc = bench_realloc;
+
+    error = FT_New_Library( memory, alibrary );
+    if ( error )
+      return error;
+
+    FT_Add_Default_Modules( *alibrary );
+    FT_Set_Default_Properties( *alibrary );
+
+    set_hinting_engines( *alibrary );
+
+    if ( lcd_filter >= 0 )
+      FT_Library_SetLcdFilter( *alibrary, (FT_LcdFilter)lcd_filter );
+    else if ( use_lcd_weights )
+      FT_Library_SetLcdFilterWeights( *alibrary, lcd_weights );
+
+    return FT_Err_Ok;
+  }
+
+
+  static FT_Error
+  library_init( void )
+  {
+    return library_new( &memory_rec, &mem_stats, &lib );
+  }
+
+
+  static FT_Error
+  set_face_size( FT_Face  face )
+  {
+    if ( !face_size )
+      return FT_Err_Ok;
+
+    if ( FT_IS_SCALABLE( face ) )
+      return FT_Set_Pixel_Sizes( face, face_size, face_size );
+    else
+      return FT_Select_Size( face, 0 );
+  }
+
+
+  static FT_Error
+  cache_init( FT_Face  face )
+  {
+    FT_Error  error;
+
+
+    error = cache_manager_new( lib,
+                               0,
+                               0,
+                               max_bytes,
+                               face_requester,
+                               face,
+                               &cache_man );
+    if ( error )
+      return error;
+
+    font_type.face_id = (FTC_FaceID)1;
+    font_type.width   = face_size;
+    font_type.height  = face_size;
+    font_type.flags   = load_flags;
+
+    return FT_Err_Ok;
+  }
+
+
+  static void
+  cache_done( void )
+  {
+    /* this only drops the references taken by `face_requester' */
+    if ( cache_man )
+      FTC_Manager_Done( cache_man );
+
+    cache_man   = NULL;
+    cmap_cache  = NULL;
+    image_cache = NULL;
+    sbit_cache  = NULL;
+  }
+
+
+  /*
+   * Release the library of the current thread
+   */
+
+  static void
+  library_done( void )
+  {
+    cache_done();
+
+    /* this also releases any remaining FT_Face object; */
+    /* `FT_Done_FreeType' would free our memory record  */
+    FT_Done_Library( lib );
+    lib = NULL;
+  }
+
+
+  /*
+   * Open all faces and named instances of the font file at once, as
+   * `FTDemo_Install_Font' does, either with `FT_New_Face', with a
+   * preloaded copy of the file for every face, or with a single shared
+   * mapping
+   */
+
+  enum {
+    OPEN_FILE,
+    OPEN_PRELOAD,
+    OPEN_MMAP,
+    N_OPEN_PATHS
+  };
+
+
+  static const char*  open_titles[N_OPEN_PATHS] =
+  {
+    "Open all (file)",
+    "Open all (preload)",
+    "Open all (mmap)"
+  };
+
+
+  typedef struct  bopenall_t_
+  {
+    int       path;
+    long*     indices;   /* all faces and named instances */
+    int       count;
+    FT_Face*  faces;
+    bfile_t*  files;     /* one per face, or one for all with `mmap' */
+    size_t    rss;       /* largest growth while all faces are open  */
+
+  } bopenall_t;
+
+
+  /* the resident set size in bytes, or zero if unknown */
+  static size_t
+  get_rss( void )
+  {
+#if defined UNIX && defined __linux__
+    FILE*          file = fopen( "/proc/self/statm", "r" );
+    unsigned long  size, resident = 0;
+
+
+    if ( !file )
+      return 0;
+
+    if ( fscanf( file, "%lu %lu", &size, &resident ) != 2 )
+      resident = 0;
+    fclose( file );
+
+    return (size_t)resident * (size_t)sysconf( _SC_PAGESIZE );
+#else
+    return 0;
+#endif
+  }
+
+
+  static int
+  test_open_all( btimer_t*  timer,
+                 FT_Face    face,
+                 void*      user_data )
+  {
+    bopenall_t*  oa = (bopenall_t*)user_data;
+    size_t       rss;
+    int          k, done = 0;
+
+    FT_UNUSED( face );
+
+
+    for ( k = 0; k < oa->count; k++ )
+    {
+      oa->faces[k]      = NULL;
+      oa->files[k].base = NULL;
+    }
+
+    rss = get_rss();
+
+    TIMER_START( timer );
+
+    for ( k = 0; k < oa->count; k++ )
+    {
+      bfile_t*  file = oa->files + ( oa->path == OPEN_MMAP ? 0 : k );
+      FT_Error  error;
+
+
+      if ( oa->path == OPEN_FILE )
+        error = FT_New_Face( lib, filename, oa->indices[k], oa->faces + k );
+      else
+      {
+        if ( !file->base && file_load( filename,
+                                       oa->path == OPEN_MMAP,
+                                       file ) )
+          continue;
+
+        error = FT_New_Memory_Face( lib,
+                                    file->base,
+                                    (FT_Long)file->size,
+                                    oa->indices[k],
+                                    oa->faces + k );
+      }
+
+      if ( error )
+        oa->faces[k] = NULL;
+      else
+        done++;
+    }
+
+    TIMER_STOP( timer );
+
+    rss = get_rss() - rss;
+    if ( rss > oa->rss && rss < ( (size_t)-1 ) / 2 )
+      oa->rss = rss;
+
+    for ( k = 0; k < oa->count; k++ )
+    {
+      if ( oa->faces[k] )
+        FT_Done_Face( oa->faces[k] );
+      if ( oa->files[k].base )
+        file_unload( oa->files + k );
+    }
+
+    return done;
+  }
+
+
+  static void
+  run_open_all( FT_Face   face,
+                btest_t*  test )
+  {
+    bopenall_t  oa;
+    FT_Face     sub;
+    long        num_faces, i, j;
+
+
+    test->title = open_titles[OPEN_FILE];
+
+    /* a font file is opened as a whole */
+    if ( face_index )
+    {
+      skip( test, "only for face 0" );
+
+      return;
+    }
+
+    oa.count   = 0;
+    oa.indices = NULL;
+
+    num_faces = face->num_faces;
+    for ( i = 0; i < num_faces; i++ )
+    {
+      long   num_instances;
+      long*  indices;
+
+
+      if ( FT_New_Face( lib, filename, -( i + 1 ), &sub ) )
+        continue;
+      num_instances = sub->style_flags >> 16;
+      FT_Done_Face( sub );
+
+      indices = (long*)realloc( oa.indices,
+                                (size_t)( oa.count + num_instances + 1 ) *
+                                  sizeof ( long ) );
+      if ( !indices )
+        break;
+      oa.indices = indices;
+
+      for ( j = 0; j <= num_instances; j++ )
+        oa.indices[oa.count++] = ( j << 16 ) + i;
+    }
+
+    oa.faces = (FT_Face*)malloc( (size_t)oa.count * sizeof ( FT_Face ) );
+    oa.files = (bfile_t*)malloc( (size_t)oa.count * sizeof ( bfile_t ) );
+
+    if ( !oa.count || !oa.faces || !oa.files )
+      fail( test, "out of memory" );
+    else
+    {
+      test->bench     = test_open_all;
+      test->user_data = (void*)&oa;
+
+      for ( oa.path = 0; oa.path < N_OPEN_PATHS; oa.path++ )
+      {
+        test->title = open_titles[oa.path];
+        oa.rss      = 0;
+
+        benchmark( face, test );
+
+        if ( oa.rss && !worker )
+          printf( "  %-25s RSS +%lu KiB with %d face(s) open\n",
+                  "",
+                  (unsigned long)( oa.rss / 1024 ),
+                  oa.count );
+      }
+    }
+
+    free( oa.indices );
+    free( oa.faces );
+    free( oa.files );
+  }
+
+
+  /*
+   * Run the color glyph tests on `face'
+   */
+
+  static void
+  run_color_tests( FT_Face   face,
+                   btest_t*  test )
+  {
+    bcolor_t  color;
+    int       k;
+
+
+    test->title = "Color bitmap (metrics)";
+
+    if ( !FT_HAS_COLOR( face ) )
+    {
+      skip( test, "no color glyphs" );
+
+      return;
+    }
+
+    test->user_data = (void*)&color;
+
+    /* locating the bitmap data first, then decoding it as well */
+    /* (which means decompressing PNG data for most fonts)      */
+    color.flags = load_flags | FT_LOAD_COLOR | FT_LOAD_BITMAP_METRICS_ONLY;
+    test->bench = test_color_load;
+    if ( FT_HAS_FIXED_SIZES( face ) )
+      benchmark( face, test );
+    else
+      skip( test, "no color bitmaps" );
+
+    color.flags = load_flags | FT_LOAD_COLOR;
+    test->title = "Color bitmap (decoded)";
+    if ( FT_HAS_FIXED_SIZES( face ) )
+      benchmark( face, test );
+    else
+      skip( test, "no color bitmaps" );
+
+    test->title = "COLR layers (blended)";
+    test->bench = test_color_layers;
+    if ( !face_size )
+      skip( test, "disabled (size = 0)" );
+    else if ( FT_Palette_Select( face, 0, &color.palette ) )
+      skip( test, "no color palette" );
+    else
+      benchmark( face, test );
+
+    test->title   = "BGRA blit (RGB32)";
+    test->bench   = test_color_blit;
+    color.surface = (FT_UInt32*)malloc( BLIT_WIDTH * BLIT_HEIGHT *
+                                          sizeof ( FT_UInt32 ) );
+    if ( !color.surface )
+      fail( test, "out of memory" );
+    else
+    {
+      for ( k = 0; k < BLIT_WIDTH * BLIT_HEIGHT; k++ )
+        color.surface[k] = 0xFFFFFF;
+
+      benchmark( face, test );
+      free( color.surface );
+    }
+  }
+
+
+  /*
+   * Run the signed distance field tests on `face'
+   */
+
+  static void
+  run_sdf_tests( FT_Face   face,
+                 btest_t*  test )
+  {
+    bsdf_t   sdf;
+    FT_Int   saved_spread[N_SDF];
+    FT_Bool  saved_overlaps;
+    int      first = num_results;
+    int      k, s;
+
+
+    test->title = "SDF";
+
+    if ( !face_size )
+    {
+      skip( test, "disabled (size = 0)" );
+
+      return;
+    }
+
+    if ( FT_Property_Get( lib, "sdf", "spread", &saved_spread[0] )    ||
+         FT_Property_Get( lib, "sdf", "overlaps", &saved_overlaps )   ||
+         FT_Property_Get( lib, "bsdf", "spread", &saved_spread[1] )   )
+    {
+      skip( test, "no SDF renderers" );
+
+      return;
+    }
+
+    test->bench     = test_sdf;
+    test->user_data = (void*)&sdf;
+
+    if ( !worker )
+      for ( k = 0; k < N_SDF; k++ )
+        sdf_num_spreads[k] = SDF_SPREADS;
+
+    for ( k = 0; k < N_SDF; k++ )
+    {
+      const char*  module   = k == SDF_BITMAP ? "bsdf" : "sdf";
+      FT_Bool      overlaps = k == SDF_OVERLAPS;
+
+
+      sdf.kind = k;
+
+      for ( s = 0; s < SDF_SPREADS; s++ )
+      {
+        int  start = num_results;
+
+
+        test->title = sdf_titles[k][s];
+
+        if ( s >= sdf_num_spreads[k] )
+        {
+          skip( test, "skipped (time limit)" );
+          continue;
+        }
+
+        if ( k != SDF_BITMAP && !FT_IS_SCALABLE( face ) )
+        {
+          skip( test, "no outlines" );
+          continue;
+        }
+
+        if ( FT_Property_Set( lib, module, "spread", &sdf_spreads[s] ) ||
+             ( k != SDF_BITMAP                                      &&
+               FT_Property_Set( lib, module, "overlaps", &overlaps ) ) )
+        {
+          skip( test, "property not supported" );
+          continue;
+        }
+
+        sdf.bytes  = 0.0;
+        sdf.fields = 0.0;
+
+        benchmark( face, test );
+
+        if ( sdf.fields > 0.0 )
+          add_output_bytes( start, sdf.bytes / sdf.fields );
+
+        if ( !worker                                      &&
+             num_results > start                          &&
+             results[start].iterations > 0                &&
+             results[start].total / results[start].iterations >=
+               1E6 * max_time                             )
+          sdf_num_spreads[k] = s + 1;
+      }
+    }
+
+    FT_Property_Set( lib, "sdf", "spread", &saved_spread[0] );
+    FT_Property_Set( lib, "sdf", "overlaps", &saved_overlaps );
+    FT_Property_Set( lib, "bsdf", "spread", &saved_spread[1] );
+
+    if ( worker || num_results == first )
+      return;
+
+    printf( "\n"
+            "SDF cost (us/glyph) and output (bytes/glyph) by spread:\n"
+            "\n"
+            "  %-13s", "spread" );
+    for ( s = 0; s < SDF_SPREADS; s++ )
+      printf( " %17d", sdf_spreads[s] );
+    printf( "\n"
+            "  %-13s", "" );
+    for ( s = 0; s < SDF_SPREADS; s++ )
+      printf( " %8s %8s", "us", "bytes" );
+    printf( "\n" );
+
+    for ( k = 0; k < N_SDF; k++ )
+    {
+      printf( "  %-13s", sdf_names[k] );
+
+      for ( s = 0; s < SDF_SPREADS; s++ )
+      {
+        int  r;
+
+
+        for ( r = first; r < num_results; r++ )
+          if ( results[r].title == sdf_titles[k][s] )
+            break;
+
+        if ( r < num_results && results[r].done )
+          printf( " %8.2f %8.0f",
+                  results[r].total / results[r].done,
+                  results[r].output_bytes );
+        else
+          printf( " %8s %8s", "-", "-" );
+      }
+      printf( "\n" );
+    }
+    printf( "\n" );
+  }
+
+
+  /*
+   * Run the kerning and advance tests on `face'
+   */
+
+  static void
+  run_kerning_tests( FT_Face   face,
+                     btest_t*  test )
+  {
+    static const char*  kerning_titles[3] =
+    {
+      "Get_Kerning (default)",
+      "Get_Kerning (unfitted)",
+      "Get_Kerning (unscaled)"
+    };
+    static const FT_UInt  kerning_modes[3] =
+    {
+      FT_KERNING_DEFAULT,
+      FT_KERNING_UNFITTED,
+      FT_KERNING_UNSCALED
+    };
+
+    bkerning_t  kern;
+    FT_Fixed    kerning;
+    int         k;
+
+
+    test->title     = kerning_titles[0];
+    test->user_data = (void*)&kern;
+
+    /* the glyph pairs follow the text workload, or the sample text */
+    if ( workload )
+    {
+      kern.glyphs     = workload;
+      kern.num_glyphs = num_workload;
+    }
+    else
+    {
+      kern.glyphs = (FT_UInt*)malloc( sizeof ( kerning_text ) *
+                                        sizeof ( FT_UInt ) );
+      if ( !kern.glyphs )
+      {
+        fail( test, "out of memory" );
+
+        return;
+      }
+
+      kern.num_glyphs = 0;
+      for ( k = 0; kerning_text[k]; k++ )
+      {
+        FT_UInt  gindex = FT_Get_Char_Index( face,
+                                             (FT_ULong)kerning_text[k] );
+
+
+        if ( gindex )
+          kern.glyphs[kern.num_glyphs++] = gindex;
+      }
+    }
+
+    if ( kern.num_glyphs < 2 )
+      skip( test, "no glyph pairs" );
+    else if ( !FT_HAS_KERNING( face ) )
+      skip( test, "no kerning table" );
+    else
+    {
+      test->bench = test_kerning;
+
+      for ( k = 0; k < 3; k++ )
+      {
+        test->title = kerning_titles[k];
+        kern.mode   = kerning_modes[k];
+        benchmark( face, test );
+      }
+    }
+
+    /* only supported for Type 1 fonts with an attached AFM file */
+    test->title = "Get_Track_Kerning";
+    test->bench = test_track_kerning;
+    if ( kern.num_glyphs < 2 )
+      skip( test, "no glyph pairs" );
+    else if ( FT_Get_Track_Kerning( face,
+                                    (FT_Fixed)face_size << 16,
+                                    0,
+                                    &kerning ) )
+      skip( test, "no track kerning" );
+    else
+      benchmark( face, test );
+
+    if ( !workload )
+      free( kern.glyphs );
+
+    /* fast advances come from the metrics tables directly; the others */
+    /* need loading (and maybe hinting) a glyph; since FreeType only   */
+    /* takes the fast path for unhinted or light advances, the fast    */
+    /* variants don't hint, so that they always succeed                */
+    test->bench = test_advance;
+
+    test->title = "Get_Advance";
+    kern.flags  = load_flags;
+    benchmark( face, test );
+
+    test->title = "Get_Advance (unhinted)";
+    kern.flags  = load_flags | FT_LOAD_NO_HINTING | FT_ADVANCE_FLAG_FAST_ONLY;
+    benchmark( face, test );
+
+    test->bench = test_advances;
+
+    test->title = "Get_Advances";
+    kern.flags  = load_flags;
+    benchmark( face, test );
+
+    test->title = "Get_Advances (unhinted)";
+    kern.flags  = load_flags | FT_LOAD_NO_HINTING | FT_ADVANCE_FLAG_FAST_ONLY;
+    benchmark( face, test );
+  }
+
+
+  /*
+   * Run the rasterizer tests on `face'
+   */
+
+  static void
+  run_raster_tests( FT_Face   face,
+                    btest_t*  test )
+  {
+    static const char*  raster_titles[2][2] =
+    {
+      { "Raster (smooth)", "Raster (mono)" },
+      { "Raster (smooth spans)", "Raster (mono spans)" }
+    };
+
+    braster_t    raster;
+    FT_Renderer  renderers[2];
+    FT_Renderer  saved;
+    size_t       max_size = 0;
+    unsigned     i;
+    int          k, m;
+
+
+    test->title = raster_titles[0][0];
+
+    if ( !face_size )
+    {
+      skip( test, "disabled (size = 0)" );
+
+      return;
+    }
+
+    if ( !FT_IS_SCALABLE( face ) )
+    {
+      skip( test, "no outlines" );
+
+      return;
+    }
+
+    renderers[0] = (FT_Renderer)FT_Get_Module( lib, "smooth" );
+    renderers[1] = (FT_Renderer)FT_Get_Module( lib, "raster1" );
+    saved        = FT_Get_Renderer( lib, FT_GLYPH_FORMAT_OUTLINE );
+
+    /* load and copy all outlines up front */
+    raster.num_glyphs = 0;
+    FOREACH( i )
+      raster.num_glyphs++;
+
+    raster.glyphs = (boutline_t*)calloc( (size_t)raster.num_glyphs,
+                                         sizeof ( boutline_t ) );
+    if ( !raster.glyphs )
+    {
+      fail( test, "out of memory" );
+
+      return;
+    }
+
+    k = 0;
+    FOREACH( i )
+    {
+      FT_Outline*  source = &face->glyph->outline;
+      boutline_t*  glyph  = raster.glyphs + k;
+      FT_BBox      cbox;
+
+
+      if ( FT_Load_Glyph( face, i, load_flags | FT_LOAD_NO_BITMAP ) ||
+           face->glyph->format != FT_GLYPH_FORMAT_OUTLINE           ||
+           !source->n_points                                        )
+        continue;
+
+      if ( FT_Outline_New( lib,
+                           (FT_UInt)source->n_points,
+                           source->n_contours,
+                           &glyph->outline ) )
+        continue;
+
+      FT_Outline_Copy( source, &glyph->outline );
+
+      /* the placement of `ft_smooth_render' */
+      FT_Outline_Get_CBox( &glyph->outline, &cbox );
+      cbox.xMin &= ~63;
+      cbox.yMin &= ~63;
+      cbox.xMax  = ( cbox.xMax + 63 ) & ~63;
+      cbox.yMax  = ( cbox.yMax + 63 ) & ~63;
+
+      FT_Outline_Translate( &glyph->outline, -cbox.xMin, -cbox.yMin );
+
+      glyph->width = (unsigned int)( ( cbox.xMax - cbox.xMin ) >> 6 );
+      glyph->rows  = (unsigned int)( ( cbox.yMax - cbox.yMin ) >> 6 );
+
+      if ( (size_t)glyph->width * glyph->rows > max_size )
+        max_size = (size_t)glyph->width * glyph->rows;
+
+      k++;
+    }
+    raster.num_glyphs = k;
+
+    raster.buffer_size = max_size > RASTER_BATCH ? max_size : RASTER_BATCH;
+    raster.buffer      = (unsigned char*)malloc( raster.buffer_size );
+    if ( !raster.buffer )
+      fail( test, "out of memory" );
+    else if ( !raster.num_glyphs )
+      skip( test, "no outlines" );
+    else
+    {
+      test->bench     = test_raster;
+      test->user_data = (void*)&raster;
+
+      for ( m = 0; m < 2; m++ )
+      {
+        for ( k = 0; k < 2; k++ )
+        {
+          FT_Raster_Params  params;
+
+
+          test->title   = raster_titles[m][k];
+          raster.mono   = k;
+          raster.direct = m;
+
+          if ( !renderers[k]                              ||
+               FT_Set_Renderer( lib, renderers[k], 0, NULL ) )
+          {
+            skip( test, "no rasterizer" );
+            continue;
+          }
+
+          /* the monochrome rasterizer has no direct mode */
+          memset( &params, 0, sizeof ( params ) );
+          params.flags      = ( k ? 0 : FT_RASTER_FLAG_AA ) |
+                              FT_RASTER_FLAG_DIRECT;
+          params.gray_spans = raster_spans;
+          params.user       = &raster;
+          if ( m && FT_Outline_Render( lib,
+                                       &raster.glyphs[0].outline,
+                                       &params ) )
+          {
+            skip( test, "not supported" );
+            continue;
+          }
+
+          benchmark( face, test );
+        }
+      }
+    }
+
+    if ( saved )
+      FT_Set_Renderer( lib, saved, 0, NULL );
+
+    for ( k = 0; k < raster.num_glyphs; k++ )
+      FT_Outline_Done( lib, &raster.glyphs[k].outline );
+
+    free( raster.glyphs );
+    free( raster.buffer );
+  }
+
+
+  /*
+   * Run the outline processing tests on `face'
+   */
+
+  static void
+  run_outline_tests( FT_Face   face,
+                     btest_t*  test )
+  {
+    static const FT_Stroker_LineCap  caps[3] =
+    {
+      FT_STROKER_LINECAP_BUTT,
+      FT_STROKER_LINECAP_ROUND,
+      FT_STROKER_LINECAP_SQUARE
+    };
+    static const FT_Stroker_LineJoin  joins[4] =
+    {
+      FT_STROKER_LINEJOIN_ROUND,
+      FT_STROKER_LINEJOIN_BEVEL,
+      FT_STROKER_LINEJOIN_MITER_VARIABLE,
+      FT_STROKER_LINEJOIN_MITER_FIXED
+    };
+    static const char*  stroke_titles[3][4] =
+    {
+      { "Stroke (butt, round)", "Stroke (butt, bevel)",
+        "Stroke (butt, miter)", "Stroke (butt, fixed)" },
+      { "Stroke (round, round)", "Stroke (round, bevel)",
+        "Stroke (round, miter)", "Stroke (round, fixed)" },
+      { "Stroke (square, round)", "Stroke (square, bevel)",
+        "Stroke (square, miter)", "Stroke (square, fixed)" }
+    };
+    static const char*  embolden_titles[3] =
+    {
+      "EmboldenXY (2%)",
+      "EmboldenXY (4%)",
+      "EmboldenXY (8%)"
+    };
+
+    bglyphs_t  gl;
+    FT_Fixed   radius;
+    unsigned   i;
+    int        k, m;
+
+
+    test->title = "Outline_Decompose";
+
+    if ( !face_size )
+    {
+      skip( test, "disabled (size = 0)" );
+
+      return;
+    }
+
+    gl.num_glyphs = 0;
+    FOREACH( i )
+      gl.num_glyphs++;
+
+    gl.glyphs = (FT_Glyph*)calloc( (size_t)gl.num_glyphs,
+                                   sizeof ( FT_Glyph ) );
+    if ( !gl.glyphs )
+    {
+      fail( test, "out of memory" );
+
+      return;
+    }
+
+    k = 0;
+    FOREACH( i )
+    {
+      if ( FT_Load_Glyph( face, i, load_flags | FT_LOAD_NO_BITMAP ) ||
+           face->glyph->format != FT_GLYPH_FORMAT_OUTLINE           ||
+           FT_Get_Glyph( face->glyph, &gl.glyphs[k] )               )
+        continue;
+
+      k++;
+    }
+    gl.num_glyphs = k;
+    gl.flip       = 0;
+
+    test->user_data = (void*)&gl;
+
+    if ( !gl.num_glyphs )
+    {
+      skip( test, "no outlines" );
+      goto Exit;
+    }
+
+    test->bench = test_decompose;
+    benchmark( face, test );
+
+    for ( k = 0; k < 3; k++ )
+    {
+      test->title = embolden_titles[k];
+      test->bench = test_embolden_xy;
+      gl.strength = ( face->size->metrics.y_ppem * 64 * 2 << k ) / 100;
+      benchmark( face, test );
+    }
+
+    if ( FT_Stroker_New( lib, &gl.stroker ) || !gl.stroker )
+    {
+      test->title = "Stroke";
+      skip( test, "no stroker" );
+    }
+    else
+    {
+      radius = (FT_Fixed)( face->size->metrics.y_ppem * 64 *
+                           OUTLINE_RADIUS );
+
+      for ( k = 0; k < 3; k++ )
+      {
+        for ( m = 0; m < 4; m++ )
+        {
+          FT_Stroker_Set( gl.stroker, radius, caps[k], joins[m],
+                          4 << 16 );
+
+          test->title = stroke_titles[k][m];
+          test->bench = test_stroke_glyph;
+          benchmark( face, test );
+        }
+      }
+
+      /* `ftview' uses round caps and joins */
+      FT_Stroker_Set( gl.stroker, radius,
+                      FT_STROKER_LINECAP_ROUND,
+                      FT_STROKER_LINEJOIN_ROUND,
+                      0 );
+
+      test->title = "Stroker_ParseOutline";
+      test->bench = test_parse_outline;
+      benchmark( face, test );
+
+      test->title = "Glyph_StrokeBorder";
+      test->bench = test_stroke_border;
+      benchmark( face, test );
+
+      FT_Stroker_Done( gl.stroker );
+    }
+
+    /* these two modify the loaded outlines */
+    test->title = "Outline_Transform";
+    test->bench = test_transform;
+    benchmark( face, test );
+
+    test->title = "Outline_Translate";
+    test->bench = test_translate;
+    benchmark( face, test );
+
+  Exit:
+    for ( k = 0; k < gl.num_glyphs; k++ )
+      FT_Done_Glyph( gl.glyphs[k] );
+
+    free( gl.glyphs );
+  }
+
+
+  /*
+   * Run the bitmap processing tests on `face'
+   */
+
+  static void
+  run_bitmap_tests( FT_Face   face,
+                    btest_t*  test )
+  {
+    static const FT_Render_Mode  modes[5] =
+    {
+      FT_RENDER_MODE_NORMAL,
+      FT_RENDER_MODE_LIGHT,
+      FT_RENDER_MODE_MONO,
+      FT_RENDER_MODE_LCD,
+      FT_RENDER_MODE_LCD_V
+    };
+    static const char*  mode_titles[5] =
+    {
+      "Glyph_To_Bitmap (normal)",
+      "Glyph_To_Bitmap (light)",
+      "Glyph_To_Bitmap (mono)",
+      "Glyph_To_Bitmap (LCD)",
+      "Glyph_To_Bitmap (LCD-V)"
+    };
+    static const FT_Int  alignments[3] = { 1, 4, 8 };
+    static const char*   convert_titles[3][3] =
+    {
+      { "Bitmap_Convert (mono, 1)", "Bitmap_Convert (mono, 4)",
+        "Bitmap_Convert (mono, 8)" },
+      { "Bitmap_Convert (gray2, 1)", "Bitmap_Convert (gray2, 4)",
+        "Bitmap_Convert (gray2, 8)" },
+      { "Bitmap_Convert (gray4, 1)", "Bitmap_Convert (gray4, 4)",
+        "Bitmap_Convert (gray4, 8)" }
+    };
+    static const char*  embolden_titles[2] =
+    {
+      "Bitmap_Embolden (1px)",
+      "Bitmap_Embolden (2px)"
+    };
+
+    bbitmaps_t  bb;
+    FT_Bitmap*  sources[3];
+    FT_Bitmap   blank;
+    FT_Vector   offset;
+    FT_Color    black = { 0, 0, 0, 255 };
+    FT_Pos      x_min = 0, x_max = 0, y_min = 0, y_max = 0;
+    unsigned    i;
+    int         k, m;
+
+
+    test->title = "Glyph_To_Bitmap";
+
+    if ( !face_size )
+    {
+      skip( test, "disabled (size = 0)" );
+
+      return;
+    }
+
+    memset( &bb, 0, sizeof ( bb ) );
+    FT_Bitmap_Init( &bb.target );
+    FT_Bitmap_Init( &blank );
+
+    FOREACH( i )
+      bb.num_glyphs++;
+
+    bb.glyphs   = (FT_Glyph*)calloc( (size_t)bb.num_glyphs,
+                                     sizeof ( FT_Glyph ) );
+    bb.rendered = (FT_Glyph*)calloc( (size_t)bb.num_glyphs,
+                                     sizeof ( FT_Glyph ) );
+    bb.monos    = (FT_Bitmap*)calloc( (size_t)bb.num_glyphs,
+                                      sizeof ( FT_Bitmap ) );
+    bb.grays2   = (FT_Bitmap*)calloc( (size_t)bb.num_glyphs,
+                                      sizeof ( FT_Bitmap ) );
+    bb.grays4   = (FT_Bitmap*)calloc( (size_t)bb.num_glyphs,
+                                      sizeof ( FT_Bitmap ) );
+    bb.copies   = (FT_Bitmap*)calloc( (size_t)bb.num_glyphs,
+                                      sizeof ( FT_Bitmap ) );
+    if ( !bb.glyphs || !bb.rendered || !bb.monos ||
+         !bb.grays2 || !bb.grays4   || !bb.copies )
+    {
+      fail( test, "out of memory" );
+      bb.num_glyphs = 0;
+      goto Exit;
+    }
+
+    /* the mono bitmaps are taken from temporary bitmap glyphs */
+    k = 0;
+    FOREACH( i )
+    {
+      FT_Glyph        mono;
+      FT_BitmapGlyph  gray;
+
+
+      if ( FT_Load_Glyph( face, i, load_flags | FT_LOAD_NO_BITMAP ) ||
+           face->glyph->format != FT_GLYPH_FORMAT_OUTLINE           ||
+           FT_Get_Glyph( face->glyph, &bb.glyphs[k] )               )
+        continue;
+
+      bb.rendered[k] = bb.glyphs[k];
+      mono           = bb.glyphs[k];
+      if ( FT_Glyph_To_Bitmap( &bb.rendered[k],
+                               FT_RENDER_MODE_NORMAL, NULL, 0 ) ||
+           FT_Glyph_To_Bitmap( &mono, FT_RENDER_MODE_MONO, NULL, 0 ) )
+      {
+        if ( bb.rendered[k] != bb.glyphs[k] )
+          FT_Done_Glyph( bb.rendered[k] );
+        FT_Done_Glyph( bb.glyphs[k] );
+        continue;
+      }
+
+      FT_Bitmap_Init( &bb.monos[k] );
+      FT_Bitmap_Init( &bb.copies[k] );
+      FT_Bitmap_Copy( lib, &( (FT_BitmapGlyph)mono )->bitmap, &bb.monos[k] );
+      FT_Done_Glyph( mono );
+
+      gray = (FT_BitmapGlyph)bb.rendered[k];
+      pack_gray( &gray->bitmap, &bb.grays2[k], 2 );
+      pack_gray( &gray->bitmap, &bb.grays4[k], 4 );
+
+      /* the union of all bitmaps, for a blend target big enough */
+      if ( x_min > gray->left )
+        x_min = gray->left;
+      if ( x_max < gray->left + (FT_Pos)gray->bitmap.width )
+        x_max = gray->left + (FT_Pos)gray->bitmap.width;
+      if ( y_min > gray->top - (FT_Pos)gray->bitmap.rows )
+        y_min = gray->top - (FT_Pos)gray->bitmap.rows;
+      if ( y_max < gray->top )
+        y_max = gray->top;
+
+      k++;
+    }
+    bb.num_glyphs = k;
+
+    test->user_data = (void*)&bb;
+
+    if ( !bb.num_glyphs )
+    {
+      skip( test, "no outlines" );
+      goto Exit;
+    }
+
+    for ( k = 0; k < 5; k++ )
+    {
+      test->title    = mode_titles[k];
+      test->bench    = test_glyph_to_bitmap;
+      bb.render_mode = modes[k];
+      benchmark( face, test );
+    }
+
+    sources[0] = bb.monos;
+    sources[1] = bb.grays2;
+    sources[2] = bb.grays4;
+
+    for ( k = 0; k < 3; k++ )
+    {
+      for ( m = 0; m < 3; m++ )
+      {
+        test->title  = convert_titles[k][m];
+        test->bench  = test_bitmap_convert;
+        bb.sources   = sources[k];
+        bb.alignment = alignments[m];
+        benchmark( face, test );
+      }
+    }
+
+    test->title = "Bitmap_Copy";
+    test->bench = test_bitmap_copy;
+    benchmark( face, test );
+
+    for ( k = 0; k < 2; k++ )
+    {
+      test->title = embolden_titles[k];
+      test->bench = test_bitmap_embolden;
+      bb.strength = 64 << k;
+      benchmark( face, test );
+    }
+
+    FT_Bitmap_Done( lib, &bb.target );
+
+    /* an empty target gets the size of the first source blended */
+    test->title   = "Bitmap_Blend (new target)";
+    test->bench   = test_bitmap_blend;
+    bb.new_target = 1;
+    benchmark( face, test );
+
+    /* a BGRA target covering every glyph, so that it is never resized; */
+    /* blending an empty source of that size lets FreeType allocate it  */
+    test->title   = "Bitmap_Blend";
+    bb.new_target = 0;
+
+    blank.rows       = (unsigned int)( y_max - y_min );
+    blank.width      = (unsigned int)( x_max - x_min );
+    blank.pitch      = (int)blank.width;
+    blank.num_grays  = 256;
+    blank.pixel_mode = FT_PIXEL_MODE_GRAY;
+    blank.buffer     = (unsigned char*)calloc(
+                         (size_t)blank.pitch * blank.rows + 1, 1 );
+
+    offset.x = x_min * 64;
+    offset.y = y_max * 64;
+
+    if ( !blank.buffer                         ||
+         FT_Bitmap_Blend( lib, &blank, offset,
+                          &bb.target, &bb.target_offset,
+                          black )              )
+      fail( test, "couldn't create target" );
+    else
+      benchmark( face, test );
+
+    free( blank.buffer );
+    FT_Bitmap_Done( lib, &bb.target );
+
+  Exit:
+    for ( k = 0; k < bb.num_glyphs; k++ )
+    {
+      FT_Done_Glyph( bb.glyphs[k] );
+      FT_Done_Glyph( bb.rendered[k] );
+      FT_Bitmap_Done( lib, &bb.monos[k] );
+      FT_Bitmap_Done( lib, &bb.copies[k] );
+      free( bb.grays2[k].buffer );
+      free( bb.grays4[k].buffer );
+    }
+
+    free( bb.glyphs );
+    free( bb.rendered );
+    free( bb.monos );
+    free( bb.grays2 );
+    free( bb.grays4 );
+    free( bb.copies );
+  }
+
+
+  /*
+   * Run the variable font tests on `face'
+   */
+
+  static void
+  run_variation_tests( FT_Face   face,
+                       btest_t*  test )
+  {
+    bvariation_t  var;
+    FT_Fixed*     saved;
+    FT_UInt       k, n;
+
+
+    test->title = "Set_Var_Design_Coords";
+
+    if ( !FT_HAS_MULTIPLE_MASTERS( face ) ||
+         FT_Get_MM_Var( face, &var.mm )    )
+    {
+      skip( test, "no variation axes" );
+
+      return;
+    }
+
+    var.num_axis = var.mm->num_axis;
+    var.step     = 0;
+
+    /* one more row to restore the current coordinates afterwards */
+    var.coords = (FT_Fixed*)malloc( ( VAR_STEPS + 1 ) * var.num_axis *
+                                      sizeof ( FT_Fixed ) );
+    if ( !var.coords )
+    {
+      fail( test, "out of memory" );
+      FT_Done_MM_Var( lib, var.mm );
+
+      return;
+    }
+
+    saved = var_coords( &var, VAR_STEPS );
+    FT_Get_Var_Design_Coordinates( face, var.num_axis, saved );
+
+    /* evenly spaced instances strictly between the axis extremes */
+    for ( k = 0; k < VAR_STEPS; k++ )
+    {
+      for ( n = 0; n < var.num_axis; n++ )
+      {
+        FT_Var_Axis*  axis = var.mm->axis + n;
+        FT_Fixed      pos;
+
+
+        pos = axis->minimum + FT_MulDiv( axis->maximum - axis->minimum,
+                                         (FT_Long)k + 1,
+                                         VAR_STEPS + 1 );
+
+        /* for MM fonts, round the design coordinates to integers */
+        if ( !FT_IS_SFNT( face ) )
+          pos = FT_RoundFix( pos );
+
+        var_coords( &var, k )[n] = pos;
+      }
+    }
+
+    test->user_data = (void*)&var;
+
+    test->bench = test_var_set;
+    benchmark( face, test );
+
+    test->title = "Load (interpolated)";
+    test->bench = test_var_load;
+    benchmark( face, test );
+
+    test->title = "Set_Named_Instance";
+    test->bench = test_var_named;
+    if ( FT_IS_SFNT( face ) && var.mm->num_namedstyles )
+      benchmark( face, test );
+    else
+      skip( test, "no named instances" );
+
+    /* the image cache sees every instance as a face ID of its own; */
+    /* either all instances stay resident or only the current one   */
+    for ( k = 0; k < 2; k++ )
+    {
+      int  first = num_results;
+
+
+      test->title = k ? "Image cache (flushed)" : "Image cache (instances)";
+      test->bench = test_var_cache;
+
+      var.flush  = (int)k;
+      var.step   = 0;
+      var.hits   = 0;
+      var.misses = 0;
+
+      if ( cache_manager_new( lib,
+                              VAR_STEPS,
+                              VAR_STEPS,
+                              max_bytes,
+                              var_face_requester,
+                              &var,
+                              &var.manager ) )
+      {
+        fail( test, "couldn't create cache" );
+        continue;
+      }
+
+      if ( FTC_ImageCache_New( var.manager, &var.cache ) )
+        fail( test, "couldn't create cache" );
+      else
+      {
+        benchmark( face, test );
+        add_hits( first, var.hits, var.misses );
+      }
+
+      FTC_Manager_Done( var.manager );
+    }
+
+    /* back to the instance selected by the face index */
+    if ( FT_IS_SFNT( face ) )
+      FT_Set_Named_Instance( face, (FT_UInt)( face_index >> 16 ) );
+    else
+      FT_Set_Var_Design_Coordinates( face, var.num_axis, saved );
+
+    free( var.coords );
+    FT_Done_MM_Var( lib, var.mm );
+  }
+
+
+  /*
+   * Run all selected tests on `face'
+   */
+
+  static void
+  run_tests( FT_Face  face )
+  {
+    int  j;
+
+
+    for ( j = 0; j < N_FT_BENCH; j++ )
+    {
+      btest_t   test;
+      FT_ULong  flags;
+
+
+      if ( !TEST( 'a' + j ) )
+        continue;
+
+      current_test = j;
+
+      test.title       = NULL;
+      test.bench       = NULL;
+      test.cache_first = 0;
+      test.user_data   = NULL;
+
+      switch ( j )
+      {
+      case FT_BENCH_LOAD_GLYPH:
+        test.title = "Load";
+        test.bench = test_load;
+        benchmark( face, &test );
+
+        if ( compare_cached )
+        {
+          test.cache_first = 1;
+
+          test.title = "Load (image cached)";
+          test.bench = test_image_cache;
+          benchmark( face, &test );
+
+          test.title = "Load (sbit cached)";
+          test.bench = test_sbit_cache;
+          if ( face_size )
+            benchmark( face, &test );
+          else
+            skip( &test, "disabled (size = 0)" );
+        }
+        break;
+
+      case FT_BENCH_LOAD_ADVANCES:
+        test.user_data = &flags;
+
+        test.title = "Load_Advances (Normal)";
+        test.bench = test_load_advances;
+        flags      = FT_LOAD_DEFAULT;
+        benchmark( face, &test );
+
+        test.title  = "Load_Advances (Fast)";
+        test.bench  = test_load_advances;
+        flags       = FT_LOAD_TARGET_LIGHT;
+        benchmark( face, &test );
+
+        test.title  = "Load_Advances (Unscaled)";
+        test.bench  = test_load_advances;
+        flags       = FT_LOAD_NO_SCALE;
+        benchmark( face, &test );
+        break;
+
+      case FT_BENCH_RENDER:
+        test.title = "Render";
+        test.bench = test_render;
+        if ( face_size )
+          benchmark( face, &test );
+        else
+          skip( &test, "disabled (size = 0)" );
+        break;
+
+      case FT_BENCH_GET_GLYPH:
+        test.title = "Get_Glyph";
+        test.bench = test_get_glyph;
+        benchmark( face, &test );
+        break;
+
+      case FT_BENCH_GET_CBOX:
+        test.title = "Get_CBox";
+        test.bench = test_get_cbox;
+        benchmark( face, &test );
+        break;
+
+      case FT_BENCH_GET_BBOX:
+        test.title = "Get_BBox";
+        test.bench = test_get_bbox;
+        benchmark( face, &test );
+        break;
+
+      case FT_BENCH_CMAP:
+        {
+          bcharset_t  charset;
+
+
+          get_charset( face, &charset );
+          if ( charset.code )
+          {
+            test.user_data = (void*)&charset;
+
+
+            test.title = "Get_Char_Index";
+            test.bench = test_get_char_index;
+
+            benchmark( face, &test );
+
+            if ( compare_cached )
+            {
+              test.cache_first = 1;
+
+              test.title = "Get_Char_Index (cached)";
+              test.bench = test_cmap_cache;
+              benchmark( face, &test );
+            }
+
+            free( charset.code );
+          }
+        }
+        break;
+
+      case FT_BENCH_CMAP_ITER:
+        test.title = "Iterate CMap";
+        test.bench = test_cmap_iter;
+        benchmark( face, &test );
+        break;
+
+      case FT_BENCH_NEW_FACE:
+        test.title = "New_Face";
+        test.bench = test_new_face;
+        benchmark( face, &test );
+        break;
+
+      case FT_BENCH_EMBOLDEN:
+        test.title = "Embolden";
+        test.bench = test_embolden;
+        if ( face_size )
+          benchmark( face, &test );
+        else
+          skip( &test, "disabled (size = 0)" );
+        break;
+
+      case FT_BENCH_STROKE:
+        test.title = "Stroke";
+        test.bench = test_stroke;
+        if ( face_size )
+          benchmark( face, &test );
+        else
+          skip( &test, "disabled (size = 0)" );
+        break;
+
+      case FT_BENCH_NEW_FACE_AND_LOAD_GLYPH:
+        test.title = "New_Face & load glyph(s)";
+        test.bench = test_new_face_and_load_glyph;
+        benchmark( face, &test );
+        break;
+
+      case FT_BENCH_VARIATIONS:
+        run_variation_tests( face, &test );
+        break;
+
+      case FT_BENCH_OPEN_ALL:
+        run_open_all( face, &test );
+        break;
+
+      case FT_BENCH_COLOR:
+        run_color_tests( face, &test );
+        break;
+
+      case FT_BENCH_SDF:
+        run_sdf_tests( face, &test );
+        break;
+
+      case FT_BENCH_KERNING:
+        run_kerning_tests( face, &test );
+        break;
+
+      case FT_BENCH_RASTER:
+        run_raster_tests( face, &test );
+        break;
+
+      case FT_BENCH_OUTLINE:
+        run_outline_tests( face, &test );
+        break;
+
+      case FT_BENCH_BITMAP:
+        run_bitmap_tests( face, &test );
+        break;
+      }
+    }
+
+    current_test = -1;
+  }
+
+
+  /*
+   * Multi-threaded runs
+   */
+
+#ifdef BENCH_THREADS
+
+  typedef struct  bthread_t_
+  {
+    pthread_t   id;
+    bresult_t*  results;
+    int         num_results;
+
+  } bthread_t;
+
+
+  static void*
+  bench_thread( void*  arg )
+  {
+    bthread_t*  thread = (bthread_t*)arg;
+    FT_Face     face   = NULL;
+    FT_Error    error;
+#ifdef BENCH_PERF
+    int         counters;
+#endif
+
+
+    worker = 1;
+
+#ifdef BENCH_PERF
+    counters = use_counters && perf_init();
+#endif
+
+    error = library_init();
+    if ( !error )
+      error = get_face( &face );
+    if ( !error )
+      error = set_face_size( face );
+    if ( !error )
+      error = cache_init( face );
+
+    if ( error )
+      bench_fail();
+
+    /* don't start before every thread has its face ready */
+    bench_sync();
+
+    pthread_mutex_lock( &sync_mutex );
+    error = thread_failed;
+    pthread_mutex_unlock( &sync_mutex );
+
+    if ( !error )
+      run_tests( face );
+
+    if ( lib )
+      library_done();
+
+#ifdef BENCH_PERF
+    if ( counters )
+      perf_done();
+#endif
+
+    thread->results     = results;
+    thread->num_results = num_results;
+
+    return NULL;
+  }
+
+
+  /*
+   * Run the tests again in `num_threads' threads and compare with the
+   * single-threaded results of the calling thread, starting at index
+   * `first'.
+   */
+
+  static void
+  run_threads( int  first )
+  {
+    bthread_t*  threads;
+    int         n, k, started;
+
+
+    threads = (bthread_t*)calloc( (size_t)num_threads, sizeof ( bthread_t ) );
+    if ( !threads )
+      return;
+
+    /* no thread is running, so a failed run can't interfere */
+    thread_failed = 0;
+    sync_count    = 0;
+
+    printf( "\n"
+            "executing tests in %d threads:\n",
+            num_threads );
+    fflush( stdout );
+
+    for ( started = 0; started < num_threads; started++ )
+      if ( pthread_create( &threads[started].id, NULL,
+                           bench_thread, threads + started ) )
+        break;
+
+    if ( started < num_threads )
+    {
+      /* release the threads already waiting for their siblings */
+      bench_fail();
+
+      fprintf( stderr, "couldn't create thread\n" );
+    }
+
+    for ( n = 0; n < started; n++ )
+      pthread_join( threads[n].id, NULL );
+
+    if ( thread_failed )
+      printf( "  multi-threaded run failed\n" );
+    else
+    {
+      for ( k = 0; first + k < num_results; k++ )
+      {
+        bresult_t*  single = results + first + k;
+        double      single_rate, rate = 0.0, total = 0.0;
+        int         done = 0;
+
+
+        for ( n = 0; n < num_threads; n++ )
+        {
+          bresult_t*  r;
+
+
+          if ( k >= threads[n].num_results )
+            break;
+
+          r = threads[n].results + k;
+          if ( r->total > 0.0 )
+            rate += 1E6 * r->done / r->total;
+
+          total += r->total;
+          done  += r->done;
+        }
+
+        printf( "  %-25s ", single->title );
+
+        if ( n < num_threads || !done || !single->done )
+        {
+          printf( "no error-free calls\n" );
+          continue;
+        }
+
+        single_rate = 1E6 * single->done / single->total;
+
+        printf( "%12.0f ops/s %10.3f us/op %6.1f%% efficiency\n",
+                rate,
+                total / (double)done,
+                100.0 * rate / ( num_threads * single_rate ) );
+      }
+    }
+
+    for ( n = 0; n < started; n++ )
+      free_results( threads[n].results, threads[n].num_results );
+    free( threads );
+  }
+
+#endif /* BENCH_THREADS */
+
+
+  /*
+   * Corpus mode
+   */
+
+  static void
+  add_font_file( const char*  name )
+  {
+    if ( num_font_files == max_font_files )
+    {
+      int     new_max   = max_font_files ? 2 * max_font_files : 16;
+      char**  new_files = (char**)realloc( font_files,
+                                           (size_t)new_max *
+                                             sizeof ( char* ) );
+
+
+      if ( !new_files )
+        return;
+
+      font_files     = new_files;
+      max_font_files = new_max;
+    }
+
+    font_files[num_font_files] = ft_strdup( name );
+    if ( font_files[num_font_files] )
+      num_font_files++;
+  }
+
+
+#ifdef UNIX
+
+  static int
+  compare_strings( const void*  a,
+                   const void*  b )
+  {
+    return strcmp( *(char* const*)a, *(char* const*)b );
+  }
+
+#endif
+
+
+  /* add all files below directory `name' in alphabetical order; */
+  /* return 0 if `name' is not a directory                       */
+  static int
+  add_font_dir( const char*  name )
+  {
+#ifdef UNIX
+    DIR*            dir;
+    struct dirent*  entry;
+    int             first = num_font_files;
+    int             k, last;
+
+
+    dir = opendir( name );
+    if ( !dir )
+      return 0;
+
+    while ( ( entry = readdir( dir ) ) != NULL )
+    {
+      struct stat  st;
+      size_t       len;
+      char*        path;
+
+
+      if ( entry->d_name[0] == '.' )
+        continue;
+
+      len  = strlen( name ) + strlen( entry->d_name ) + 2;
+      path = (char*)malloc( len );
+      if ( !path )
+        break;
+
+      snprintf( path, len, "%s%s%s",
+                name,
+                name[strlen( name ) - 1] == '/' ? "" : "/",
+                entry->d_name );
+
+      /* don't follow symbolic links to avoid loops */
+      if ( !lstat( path, &st ) && ( S_ISREG( st.st_mode ) ||
+                                    S_ISDIR( st.st_mode ) ) )
+        add_font_file( path );
+
+      free( path );
+    }
+
+    closedir( dir );
+
+    last = num_font_files;
+    qsort( font_files + first, (size_t)( last - first ), sizeof ( char* ),
+           compare_strings );
+
+    /* replace subdirectories with their contents */
+    for ( k = first; k < last; k++ )
+    {
+      if ( add_font_dir( font_files[k] ) )
+      {
+        free( font_files[k] );
+        font_files[k] = NULL;
+      }
+    }
+
+    return 1;
+#else
+    FT_UNUSED( name );
+
+    return 0;
+#endif
+  }
+
+
+  /* add the files listed one per line in file `name' */
+  static void
+  add_font_list( const char*  name )
+  {
+    FILE*  file = fopen( name, "r" );
+    char   line[1024];
+
+
+    if ( !file )
+    {
+      fprintf( stderr, "couldn't open file list `%s'\n", name );
+
+      return;
+    }
+
+    while ( fgets( line, sizeof ( line ), file ) )
+    {
+      line[strcspn( line, "\r\n" )] = '\0';
+      if ( line[0] && line[0] != '#' && !add_font_dir( line ) )
+        add_font_file( line );
+    }
+
+    fclose( file );
+  }
+
+
+  /*
+   * Text workloads
+   */
+
+#define WORKLOAD_SIZE  10000      /* characters drawn from a distribution */
+#define MAX_WORKLOAD   ( 1 << 20 )
+
+
+  /*
+   * Read a workload: either UTF-8 text or, if it starts with `U+', a
+   * frequency table with lines `U+XXXX count'
+   */
+
+  static int
+  load_workload( const char*  name )
+  {
+    FILE*           file = fopen( name, "rb" );
+    unsigned char*  text;
+    size_t          size;
+    int             max  = 0;
+
+
+    if ( !file )
+    {
+      fprintf( stderr, "couldn't open workload `%s'\n", name );
+
+      return 0;
+    }
+
+    fseek( file, 0, SEEK_END );
+    size = (size_t)ftell( file );
+    fseek( file, 0, SEEK_SET );
+
+    text = (unsigned char*)malloc( size + 1 );
+    if ( !text || ( size && !fread( text, size, 1, file ) ) )
+    {
+      fprintf( stderr, "couldn't read workload `%s'\n", name );
+      free( text );
+      fclose( file );
+
+      return 0;
+    }
+    text[size] = '\0';
+
+    fclose( file );
+
+    if ( size > 1 && text[0] == 'U' && text[1] == '+' )
+    {
+      char*  p = (char*)text;
+
+
+      while ( *p )
+      {
+        unsigned long  code;
+        double         count;
+
+
+        if ( p[0] == 'U' && p[1] == '+' )
+        {
+          code  = strtoul( p + 2, &p, 16 );
+          count = strtod( p, &p );
+
+          if ( count > 0 )
+          {
+            if ( num_workload_codes == max )
+            {
+              int        new_max    = max ? 2 * max : 256;
+              FT_ULong*  new_codes;
+              double*    new_counts;
+
+
+              /* on failure, keep the entries read so far */
+              new_codes = (FT_ULong*)realloc( workload_codes,
+                                              (size_t)new_max *
+                                                sizeof ( FT_ULong ) );
+              if ( !new_codes )
+                break;
+              workload_codes = new_codes;
+
+              new_counts = (double*)realloc( workload_counts,
+                                             (size_t)new_max *
+                                               sizeof ( double ) );
+              if ( !new_counts )
+                break;
+              workload_counts = new_counts;
+
+              max = new_max;
+            }
+
+            workload_codes[num_workload_codes]    = code;
+            workload_counts[num_workload_codes++] = count;
+          }
+        }
+
+        /* skip the rest of the line */
+        p += strcspn( p, "\n" );
+        if ( *p )
+          p++;
+      }
+    }
+    else
+    {
+      const char*  p   = (const char*)text;
+      const char*  end = p + size;
+
+
+      /* we don't need more than this */
+      workload_codes = (FT_ULong*)malloc( ( size < MAX_WORKLOAD
+                                              ? size + 1
+                                              : MAX_WORKLOAD ) *
+                                            sizeof ( FT_ULong ) );
+
+      while ( workload_codes && p < end &&
+              num_workload_codes < MAX_WORKLOAD )
+      {
+        int  c = utf8_next( &p, end );
+
+
+        /* skip malformed data byte by byte */
+        if ( c < 0 )
+        {
+          p++;
+          continue;
+        }
+
+        /* line breaks, tabs, and byte order marks are not rendered */
+        if ( c >= 0x20 && c != 0xFEFF )
+          workload_codes[num_workload_codes++] = (FT_ULong)c;
+      }
+    }
+
+    free( text );
+
+    if ( !workload_codes || !num_workload_codes )
+    {
+      fprintf( stderr, "no characters in workload `%s'\n", name );
+
+      return 0;
+    }
+
+    return 1;
+  }
+
+
+  /* draw `WORKLOAD_SIZE' characters from a distribution */
+  static void
+  workload_sample( const FT_ULong*  codes,
+                   const double*    weights,
+                   int              count )
+  {
+    double*    cdf;
+    FT_UInt32  seed = 2463534242UL;
+    int        k;
+
+
+    cdf = (double*)malloc( (size_t)count * sizeof ( double ) );
+    workload_chars = (FT_ULong*)malloc( WORKLOAD_SIZE * sizeof ( FT_ULong ) );
+    if ( !cdf || !workload_chars )
+    {
+      free( cdf );
+      free( workload_chars );
+      workload_chars = NULL;
+
+      return;
+    }
+
+    for ( k = 0; k < count; k++ )
+      cdf[k] = ( k ? cdf[k - 1] : 0.0 ) + weights[k];
+
+    for ( k = 0; k < WORKLOAD_SIZE; k++ )
+    {
+      double  x;
+      int     lo = 0, hi = count - 1;
+
+
+      /* xorshift32 */
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+
+      x = cdf[count - 1] * (double)seed / 4294967296.0;
+
+      while ( lo < hi )
+      {
+        int  mid = ( lo + hi ) / 2;
+
+
+        if ( cdf[mid] > x )
+          hi = mid;
+        else
+          lo = mid + 1;
+      }
+
+      workload_chars[k] = codes[lo];
+    }
+
+    num_workload_chars = WORKLOAD_SIZE;
+
+    free( cdf );
+  }
+
+
+  /* map the workload to the glyphs of `face' */
+  static void
+  workload_init( FT_Face  face )
+  {
+    unsigned char*  seen;
+    int             k;
+
+
+    if ( zipf_exponent > 0 )
+    {
+      bcharset_t  charset;
+      double*     weights;
+
+
+      /* rank the characters in charmap order */
+      charset.size = 0;
+      get_charset( face, &charset );
+
+      weights = (double*)malloc( (size_t)charset.size * sizeof ( double ) );
+      if ( weights && charset.size )
+      {
+        for ( k = 0; k < charset.size; k++ )
+          weights[k] = pow( (double)( k + 1 ), -zipf_exponent );
+
+        workload_sample( charset.code, weights, charset.size );
+      }
+
+      free( weights );
+      free( charset.code );
+    }
+    else if ( workload_counts )
+      workload_sample( workload_codes, workload_counts, num_workload_codes );
+    else if ( workload_codes )
+    {
+      workload_chars = (FT_ULong*)malloc( (size_t)num_workload_codes *
+                                            sizeof ( FT_ULong ) );
+      if ( workload_chars )
+      {
+        memcpy( workload_chars,
+                workload_codes,
+                (size_t)num_workload_codes * sizeof ( FT_ULong ) );
+        num_workload_chars = num_workload_codes;
+      }
+    }
+
+    if ( !workload_chars )
+      return;
+
+    workload = (unsigned int*)malloc( ( (size_t)num_workload_chars + 1 ) *
+                                        sizeof ( unsigned int ) );
+    seen     = (unsigned char*)calloc( (size_t)face->num_glyphs, 1 );
+    if ( !workload || !seen )
+    {
+      free( workload );
+      free( seen );
+      workload = NULL;
+
+      return;
+    }
+
+    /* characters the font doesn't cover would go to a fallback font */
+    num_workload          = 0;
+    num_workload_distinct = 0;
+    for ( k = 0; k < num_workload_chars; k++ )
+    {
+      FT_UInt  gindex = FT_Get_Char_Index( face, workload_chars[k] );
+
+
+      if ( !gindex || gindex >= (FT_UInt)face->num_glyphs )
+        continue;
+
+      workload[num_workload++] = gindex;
+      if ( !seen[gindex] )
+      {
+        seen[gindex] = 1;
+        num_workload_distinct++;
+      }
+    }
+    workload[num_workload] = 0;
+
+    free( seen );
+  }
+
+
+  static void
+  workload_done( void )
+  {
+    free( workload_chars );
+    free( workload );
+
+    workload_chars     = NULL;
+    num_workload_chars = 0;
+    workload           = NULL;
+    num_workload       = 0;
+  }
+
+
+  /* print aggregate results, grouped by font format and driver */
+  static void
+  print_aggregates( int  first )
+  {
+    int  g, k, m;
+
+
+    printf( "\n"
+            "aggregate results by font format (driver):\n" );
+
+    for ( g = first; g < num_results; g++ )
+    {
+      bresult_t*  rg = results + g;
+      int         num_faces = 0;
+      long        last_face = -1;
+      const char* last_font = NULL;
+
+
+      /* find the first result of every format and driver pair */
+      for ( k = first; k < g; k++ )
+        if ( !strcmp( results[k].format, rg->format ) &&
+             !strcmp( results[k].driver, rg->driver ) )
+          break;
+      if ( k < g )
+        continue;
+
+      for ( k = g; k < num_results; k++ )
+      {
+        bresult_t*  r = results + k;
+
+
+        if ( strcmp( r->format, rg->format ) ||
+             strcmp( r->driver, rg->driver ) )
+          continue;
+
+        if ( r->font != last_font || r->face_index != last_face )
+        {
+          num_faces++;
+          last_font = r->font;
+          last_face = r->face_index;
+        }
+      }
+
+      printf( "\n"
+              "  %s (%s), %d face%s\n",
+              rg->format, rg->driver, num_faces, num_faces == 1 ? "" : "s" );
+
+      /* now sum up every test title of this group */
+      for ( k = g; k < num_results; k++ )
+      {
+        bresult_t*  rk   = results + k;
+        double      total = 0.0;
+        int         done  = 0, count = 0;
+
+
+        if ( strcmp( rk->format, rg->format ) ||
+             strcmp( rk->driver, rg->driver ) )
+          continue;
+
+        for ( m = g; m < k; m++ )
+          if ( !strcmp( results[m].format, rg->format ) &&
+               !strcmp( results[m].driver, rg->driver ) &&
+               !strcmp( results[m].title, rk->title ) )
+            break;
+        if ( m < k )
+          continue;
+
+        for ( m = k; m < num_results; m++ )
+        {
+          bresult_t*  r = results + m;
+
+
+          if ( strcmp( r->format, rg->format ) ||
+               strcmp( r->driver, rg->driver ) ||
+               strcmp( r->title, rk->title )   )
+            continue;
+
+          total += r->total;
+          done  += r->done;
+          count++;
+        }
+
+        printf( "    %-25s ", rk->title );
+        if ( done )
+          printf( "%10.3f us/op %10d done %6d faces\n",
+                  total / done, done, count );
+        else
+          printf( "no error-free calls\n" );
+      }
+    }
+  }
+
+
+  /*
+   * Machine-readable output
+   */
+
+  static void
+  get_cpu_model( char*   buf,
+                 size_t  size )
+  {
+    snprintf( buf, size, "unknown" );
+
+#ifdef UNIX
+    {
+      FILE*  file = fopen( "/proc/cpuinfo", "r" );
+      char   line[256];
+
+
+      if ( !file )
+        return;
+
+      while ( fgets( line, sizeof ( line ), file ) )
+      {
+        char*  p = strchr( line, ':' );
+
+
+        if ( strncmp( line, "model name", 10 ) || !p )
+          continue;
+
+        p++;
+        while ( *p == ' ' || *p == '\t' )
+          p++;
+        p[strcspn( p, "\n" )] = '\0';
+
+        snprintf( buf, size, "%s", p );
+        break;
+      }
+
+      fclose( file );
+    }
+#endif
+  }
+
+
+  static void
+  put_json_string( FILE*        file,
+                   const char*  str )
+  {
+    putc( '"', file );
+
+    for ( ; *str; str++ )
+    {
+      unsigned char  c = (unsigned char)*str;
+
+
+      if ( c == '"' || c == '\\' )
+        fprintf( file, "\\%c", c );
+      else if ( c < 0x20 )
+        fprintf( file, "\\u%04x", c );
+      else
+        putc( c, file );
+    }
+
+    putc( '"', file );
+  }
+
+
+  static void
+  put_csv_string( FILE*        file,
+                  const char*  str )
+  {
+    if ( !strpbrk( str, ",\"\n" ) )
+    {
+      fputs( str, file );
+      return;
+    }
+
+    putc( '"', file );
+
+    for ( ; *str; str++ )
+    {
+      if ( *str == '"' )
+        putc( '"', file );
+      putc( *str, file );
+    }
+
+    putc( '"', file );
+  }
+
+
+  static void
+  write_results( const char*  name )
+  {
+    FILE*   file;
+    size_t  len   = strlen( name );
+    int     csv   = len > 4 && !strcmp( name + len - 4, ".csv" );
+    char    cpu[128];
+    char    version[32];
+    char    host[64] = "unknown";
+    FT_Int  major, minor, patch;
+    int     j, k;
+
+
+    file = fopen( name, "w" );
+    if ( !file )
+    {
+      fprintf( stderr, "couldn't open `%s' for writing\n", name );
+
+      return;
+    }
+
+    get_cpu_model( cpu, sizeof ( cpu ) );
+
+    FT_Library_Version( lib, &major, &minor, &patch );
+    snprintf( version, sizeof ( version ), "%d.%d.%d", major, minor, patch );
+
+#ifdef UNIX
+    if ( gethostname( host, sizeof ( host ) ) )
+      snprintf( host, sizeof ( host ), "unknown" );
+    host[sizeof ( host ) - 1] = '\0';
+#endif
+
+    if ( csv )
+      fprintf( file,
+               "host,cpu,freetype,test,font,face_index,format,driver,"
+               "size,load_flags,"
+               "render_mode,tt_interpreter_version,ps_hinting_engine,"
+               "iterations,total_us,us_per_op,done,"
+               "samples,mean,median,stddev,p5,p95,p99,ci95,"
+               "cycles,instructions,L1d_misses,LLC_misses,branch_misses,"
+               "allocs,reallocs,frees,alloc_bytes,peak_bytes,"
+               "cache_hits,cache_misses,output_bytes\n" );
+    else
+    {
+      fprintf( file, "{\n"
+                     "  \"host\": " );
+      put_json_string( file, host );
+      fprintf( file, ",\n"
+                     "  \"cpu\": " );
+      put_json_string( file, cpu );
+      fprintf( file, ",\n"
+                     "  \"freetype\": \"%s\",\n"
+                     "  \"threads\": %d,\n"
+                     "  \"max_iterations\": %d,\n"
+                     "  \"max_seconds\": %g,\n"
+                     "  \"warmup_iterations\": %d,\n"
+                     "  \"target_error\": %g,\n"
+                     "  \"results\": [",
+                     version,
+                     num_threads,
+                     max_iter,
+                     max_time,
+                     warmup_iter,
+                     target_error );
+    }
+
+    for ( k = 0; k < num_results; k++ )
+    {
+      bresult_t*  r      = results + k;
+      double      per_op = r->done ? r->total / (double)r->done : 0.0;
+
+
+      if ( csv )
+      {
+        put_csv_string( file, host );
+        putc( ',', file );
+        put_csv_string( file, cpu );
+        fprintf( file, ",%s,", version );
+        put_csv_string( file, r->title );
+        putc( ',', file );
+        put_csv_string( file, r->font );
+        fprintf( file, ",%ld,", r->face_index );
+        put_csv_string( file, r->format );
+        putc( ',', file );
+        put_csv_string( file, r->driver );
+        fprintf( file, ",%u,0x%X,%d,%u,%s,%d,%.3f,%.6f,%d,"
+                       "%d,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,",
+                 r->size,
+                 r->load_flags,
+                 r->render_mode,
+                 r->tt_interpreter_version,
+                 ps_hinting_engine_names[r->ps_hinting_engine],
+                 r->iterations,
+                 r->total,
+                 per_op,
+                 r->done,
+                 r->stats.count,
+                 r->stats.mean,
+                 r->stats.median,
+                 r->stats.stddev,
+                 r->stats.p5,
+                 r->stats.p95,
+                 r->stats.p99,
+                 r->stats.ci95 );
+
+        /* hardware counters stay empty unless requested */
+        for ( j = 0; j < N_COUNTERS; j++ )
+          if ( use_counters )
+            fprintf( file, "%s%.0f", j ? "," : "", r->counters[j] );
+          else if ( j )
+            putc( ',', file );
+        fprintf( file, ",%lu,%lu,%lu,%.0f,%lu,%lu,%lu,%.0f\n",
+                 r->mem.allocs,
+                 r->mem.reallocs,
+                 r->mem.frees,
+                 r->mem.bytes,
+                 (unsigned long)r->mem.peak,
+                 r->cache_hits,
+                 r->cache_misses,
+                 r->output_bytes );
+      }
+      else
+      {
+        fprintf( file, "%s\n"
+                       "    {\n"
+                       "      \"test\": ",
+                       k ? "," : "" );
+        put_json_string( file, r->title );
+        fprintf( file, ",\n"
+                       "      \"font\": " );
+        put_json_string( file, r->font );
+        fprintf( file, ",\n"
+                       "      \"face_index\": %ld,\n"
+                       "      \"format\": ",
+                       r->face_index );
+        put_json_string( file, r->format );
+        fprintf( file, ",\n"
+                       "      \"driver\": " );
+        put_json_string( file, r->driver );
+        fprintf( file, ",\n"
+                       "      \"size\": %u,\n"
+                       "      \"load_flags\": %d,\n"
+                       "      \"render_mode\": %d,\n"
+                       "      \"tt_interpreter_version\": %u,\n"
+                       "      \"ps_hinting_engine\": \"%s\",\n"
+                       "      \"iterations\": %d,\n"
+                       "      \"total_us\": %.3f,\n"
+                       "      \"us_per_op\": %.6f,\n"
+                       "      \"done\": %d,\n"
+                       "      \"samples\": %d,\n"
+                       "      \"mean\": %.6f,\n"
+                       "      \"median\": %.6f,\n"
+                       "      \"stddev\": %.6f,\n"
+                       "      \"p5\": %.6f,\n"
+                       "      \"p95\": %.6f,\n"
+                       "      \"p99\": %.6f,\n"
+                       "      \"ci95\": %.6f,\n"
+                       "      \"allocs\": %lu,\n"
+                       "      \"reallocs\": %lu,\n"
+                       "      \"frees\": %lu,\n"
+                       "      \"alloc_bytes\": %.0f,\n"
+                       "      \"peak_bytes\": %lu",
+                       r->size,
+                       r->load_flags,
+                       r->render_mode,
+                       r->tt_interpreter_version,
+                       ps_hinting_engine_names[r->ps_hinting_engine],
+                       r->iterations,
+                       r->total,
+                       per_op,
+                       r->done,
+                       r->stats.count,
+                       r->stats.mean,
+                       r->stats.median,
+                       r->stats.stddev,
+                       r->stats.p5,
+                       r->stats.p95,
+                       r->stats.p99,
+                       r->stats.ci95,
+                       r->mem.allocs,
+                       r->mem.reallocs,
+                       r->mem.frees,
+                       r->mem.bytes,
+                       (unsigned long)r->mem.peak );
+
+        if ( r->cache_hits + r->cache_misses )
+          fprintf( file, ",\n"
+                         "      \"cache_hits\": %lu,\n"
+                         "      \"cache_misses\": %lu",
+                         r->cache_hits,
+                         r->cache_misses );
+
+        if ( r->output_bytes > 0.0 )
+          fprintf( file, ",\n"
+                         "      \"output_bytes\": %.0f",
+                         r->output_bytes );
+
+        if ( use_counters )
+        {
+          fprintf( file, ",\n"
+                         "      \"counters\": {" );
+          for ( j = 0; j < N_COUNTERS; j++ )
+            fprintf( file, "%s \"%s\": %.0f",
+                           j ? "," : "",
+                           counter_names[j],
+                           r->counters[j] );
+          fprintf( file, " }" );
+        }
+
+        fprintf( file, "\n"
+                       "    }" );
+      }
+    }
+
+    if ( !csv )
+      fprintf( file, "\n"
+                     "  ]\n"
+                     "}\n" );
+
+    fclose( file );
+  }
+
+
+  /* run the tests, then the per-glyph profile, then threads */
+  static void
+  run_all( FT_Face  face )
+  {
+    int  first_result = num_results;
+
+
+    run_tests( face );
+
+    if ( profile_top )
+      profile_glyphs( face );
+
+#ifdef BENCH_THREADS
+    if ( num_threads > 1 )
+      run_threads( first_result );
+#else
+    FT_UNUSED( first_result );
+#endif
+  }
+
+
+  /* print the time per operation of all tests against the face size */
+  static void
+  print_sweep( int  first )
+  {
+    int  k, m, n;
+
+
+    printf( "\n"
+            "cost (us/op) versus face size (ppem):\n"
+            "\n"
+            "  %-25s", "" );
+    for ( n = 0; n < num_sweep_sizes; n++ )
+      printf( " %8u", sweep_sizes[n] );
+    printf( "\n" );
+
+    for ( k = first; k < num_results; k++ )
+    {
+      bresult_t*  rk = results + k;
+
+
+      /* each title once */
+      for ( m = first; m < k; m++ )
+        if ( !strcmp( results[m].title, rk->title ) )
+          break;
+      if ( m < k )
+        continue;
+
+      printf( "  %-25s", rk->title );
+
+      for ( n = 0; n < num_sweep_sizes; n++ )
+      {
+        for ( m = k; m < num_results; m++ )
+          if ( results[m].size == sweep_sizes[n] &&
+               !strcmp( results[m].title, rk->title ) )
+            break;
+
+        if ( m < num_results && results[m].done )
+          printf( " %8.3f", results[m].total / results[m].done );
+        else
+          printf( " %8s", "-" );
+      }
+      printf( "\n" );
+    }
+  }
+
+
+  /* parse a list like `8,12,16-72:8' */
+  static void
+  parse_sizes( const char*  list )
+  {
+    const char*  p = list;
+
+
+    num_sweep_sizes = 0;
+
+    while ( *p )
+    {
+      unsigned int  from, to, step = 1;
+      char*         end;
+
+
+      from = (unsigned int)strtoul( p, &end, 10 );
+      if ( end == p )
+        break;
+      to = from;
+      p  = end;
+
+      if ( *p == '-' )
+      {
+        to = (unsigned int)strtoul( p + 1, &end, 10 );
+        p  = end;
+
+        if ( *p == ':' )
+        {
+          step = (unsigned int)strtoul( p + 1, &end, 10 );
+          p    = end;
+          if ( !step )
+            step = 1;
+        }
+      }
+
+      for ( ; from && from <= to && num_sweep_sizes < MAX_SIZES;
+            from += step )
+      {
+        int  k;
+
+
+        /* sizes given more than once are run once */
+        for ( k = 0; k < num_sweep_sizes; k++ )
+          if ( sweep_sizes[k] == from )
+            break;
+        if ( k == num_sweep_sizes )
+          sweep_sizes[num_sweep_sizes++] = from;
+
+        /* stop before `from + step' exceeds `to' (or wraps around) */
+        if ( to - from < step )
+          break;
+      }
+
+      if ( *p == ',' )
+        p++;
+      else
+        break;
+    }
+
+    if ( *p || !num_sweep_sizes )
+      fprintf( stderr, "warning: couldn't parse size list `%s'\n", list );
+  }
+
+
+  /*
+   * Render mode by LCD filter matrix
+   */
+
+#define N_MATRIX_MODES    5
+#define N_MATRIX_FILTERS  5
+
+
+  static const FT_Render_Mode  matrix_modes[N_MATRIX_MODES] =
+  {
+    FT_RENDER_MODE_MONO,
+    FT_RENDER_MODE_NORMAL,
+    FT_RENDER_MODE_LIGHT,
+    FT_RENDER_MODE_LCD,
+    FT_RENDER_MODE_LCD_V
+  };
+
+  static const char*  matrix_mode_names[N_MATRIX_MODES] =
+  {
+    "mono",
+    "normal",
+    "light",
+    "LCD",
+    "LCD_V"
+  };
+
+  static const char*  matrix_filter_names[N_MATRIX_FILTERS] =
+  {
+    "none",
+    "default",
+    "light",
+    "legacy",
+    "custom"
+  };
+
+
+  static FT_Error
+  set_matrix_filter( int  filter )
+  {
+    switch ( filter )
+    {
+    case 0:
+      return FT_Library_SetLcdFilter( lib, FT_LCD_FILTER_NONE );
+    case 1:
+      return FT_Library_SetLcdFilter( lib, FT_LCD_FILTER_DEFAULT );
+    case 2:
+      return FT_Library_SetLcdFilter( lib, FT_LCD_FILTER_LIGHT );
+    case 3:
+      return FT_Library_SetLcdFilter( lib, FT_LCD_FILTER_LEGACY );
+    default:
+      return FT_Library_SetLcdFilterWeights( lib, lcd_weights );
+    }
+  }
+
+
+  /* run the render and sbit cache tests for all combinations of render */
+  /* mode and LCD filter; this replaces the face object                 */
+  static FT_Error
+  run_render_matrix( FT_Face*  aface )
+  {
+    static char  titles[2][N_MATRIX_MODES][N_MATRIX_FILTERS][32];
+
+    FT_Render_Mode  saved_mode  = render_mode;
+    FT_Int32        saved_flags = load_flags;
+    FT_Error        error       = FT_Err_Ok;
+    int             first       = num_results;
+    int             f, m, t;
+
+
+    if ( !face_size )
+    {
+      printf( "  render matrix disabled (size = 0)\n" );
+
+      return FT_Err_Ok;
+    }
+
+    for ( f = 0; f < N_MATRIX_FILTERS; f++ )
+    {
+      /* without ClearType-style filtering (e.g., with Harmony), */
+      /* only the first column is available                      */
+      if ( set_matrix_filter( f ) && f )
+        continue;
+
+      for ( m = 0; m < N_MATRIX_MODES; m++ )
+      {
+        btest_t  test;
+
+
+        /* the cache keys don't include the filter, and the cache */
+        /* manager may destroy size objects it has used, so start */
+        /* over with a fresh face object every time               */
+        cache_done();
+        FT_Done_Face( *aface );
+
+        error = get_face( aface );
+        if ( error )
+        {
+          *aface = NULL;
+          goto Exit;
+        }
+
+        error = set_face_size( *aface );
+        if ( error )
+        {
+          fprintf( stderr, "failed to set pixel size to %u\n", face_size );
+          goto Exit;
+        }
+
+        render_mode = matrix_modes[m];
+        load_flags  = ( saved_flags & ~FT_LOAD_TARGET_( 0xF ) ) |
+                      FT_LOAD_TARGET_( render_mode );
+
+        cache_init( *aface );
+
+        for ( t = 0; t < 2; t++ )
+          snprintf( titles[t][m][f], sizeof ( titles[t][m][f] ),
+                    "%s (%s, %s)",
+                    t ? "SBit" : "Render",
+                    matrix_mode_names[m],
+                    matrix_filter_names[f] );
+
+        test.title       = titles[0][m][f];
+        test.bench       = test_render;
+        test.cache_first = 0;
+        test.user_data   = NULL;
+        benchmark( *aface, &test );
+
+        test.title       = titles[1][m][f];
+        test.bench       = test_sbit_cache;
+        test.cache_first = 1;
+        benchmark( *aface, &test );
+      }
+    }
+
+    printf( "\n"
+            "cost (us/op) by render mode and LCD filter:\n"
+            "\n"
+            "  %-16s", "" );
+    for ( f = 0; f < N_MATRIX_FILTERS; f++ )
+      printf( " %8s", matrix_filter_names[f] );
+    printf( "\n" );
+
+    for ( t = 0; t < 2; t++ )
+    {
+      for ( m = 0; m < N_MATRIX_MODES; m++ )
+      {
+        printf( "  %-6s %-9s",
+                t ? "SBit" : "Render",
+                matrix_mode_names[m] );
+
+        for ( f = 0; f < N_MATRIX_FILTERS; f++ )
+        {
+          int  k;
+
+
+          for ( k = first; k < num_results; k++ )
+            if ( results[k].title == titles[t][m][f] )
+              break;
+
+          if ( k < num_results && results[k].done )
+            printf( " %8.3f", results[k].total / results[k].done );
+          else
+            printf( " %8s", "-" );
+        }
+        printf( "\n" );
+      }
+    }
+
+  Exit:
+    render_mode = saved_mode;
+    load_flags  = saved_flags;
+
+    return error;
+  }
+
+
+  /*
+   * Hinting engine matrix
+   */
+
+#define MAX_ENGINES  7    /* three interpreters or two engines, plus two */
+
+  typedef struct  bengine_t_
+  {
+    char          name[16];
+    unsigned int  tt_interpreter_version;
+    unsigned int  ps_hinting_engine;
+    FT_Int32      load_flags;
+    int           first;        /* range of results */
+    int           last;
+
+  } bengine_t;
+
+
+  /* the time per operation of test `title' in the results of `engine' */
+  static double
+  engine_cost( bengine_t*   engine,
+               const char*  title )
+  {
+    int  k;
+
+
+    for ( k = engine->first; k < engine->last; k++ )
+      if ( results[k].done && !strcmp( results[k].title, title ) )
+        return results[k].total / results[k].done;
+
+    return 0.0;
+  }
+
+
+  /* run the tests with every hinting engine that applies to the face; */
+  /* this replaces the face object                                     */
+  static FT_Error
+  run_engine_matrix( FT_Face*  aface )
+  {
+    bengine_t     engines[MAX_ENGINES];
+    int           num_engines = 0;
+    unsigned int  saved_version = tt_interpreter_version;
+    unsigned int  saved_engine  = ps_hinting_engine;
+    FT_Int32      saved_flags   = load_flags;
+    FT_Int32      native_flags;
+    FT_Error      error         = FT_Err_Ok;
+    int           first         = num_results;
+    int           e, k, m;
+
+
+    native_flags = saved_flags & ~( FT_LOAD_NO_HINTING      |
+                                    FT_LOAD_FORCE_AUTOHINT  );
+
+    if ( !strcmp( font_driver, "truetype" ) )
+    {
+      for ( k = 0; k < num_tt_interpreter_versions; k++ )
+      {
+        bengine_t*  en = engines + num_engines++;
+
+
+        snprintf( en->name, sizeof ( en->name ),
+                  "v%u", tt_interpreter_versions[k] );
+        en->tt_interpreter_version = tt_interpreter_versions[k];
+        en->ps_hinting_engine      = saved_engine;
+        en->load_flags             = native_flags;
+      }
+    }
+    else if ( !strcmp( font_driver, "cff" )   ||
+              !strcmp( font_driver, "type1" ) ||
+              !strcmp( font_driver, "t1cid" ) )
+    {
+      for ( k = 0; k < num_ps_hinting_engines; k++ )
+      {
+        bengine_t*  en = engines + num_engines++;
+
+
+        snprintf( en->name, sizeof ( en->name ),
+                  "%s", ps_hinting_engine_names[ps_hinting_engines[k]] );
+        en->tt_interpreter_version = saved_version;
+        en->ps_hinting_engine      = ps_hinting_engines[k];
+        en->load_flags             = native_flags;
+      }
+    }
+    else
+    {
+      bengine_t*  en = engines + num_engines++;
+
+
+      snprintf( en->name, sizeof ( en->name ), "native" );
+      en->tt_interpreter_version = saved_version;
+      en->ps_hinting_engine      = saved_engine;
+      en->load_flags             = native_flags;
+    }
+
+    snprintf( engines[num_engines].name,
+              sizeof ( engines[num_engines].name ), "autohint" );
+    engines[num_engines].tt_interpreter_version = saved_version;
+    engines[num_engines].ps_hinting_engine      = saved_engine;
+    engines[num_engines].load_flags             = native_flags |
+                                                  FT_LOAD_FORCE_AUTOHINT;
+    num_engines++;
+
+    /* the reference for the relative cost */
+    snprintf( engines[num_engines].name,
+              sizeof ( engines[num_engines].name ), "unhinted" );
+    engines[num_engines].tt_interpreter_version = saved_version;
+    engines[num_engines].ps_hinting_engine      = saved_engine;
+    engines[num_engines].load_flags             = native_flags |
+                                                  FT_LOAD_NO_HINTING;
+    num_engines++;
+
+    for ( e = 0; e < num_engines; e++ )
+    {
+      bengine_t*  en = engines + e;
+
+
+      tt_interpreter_version = en->tt_interpreter_version;
+      ps_hinting_engine      = en->ps_hinting_engine;
+      load_flags             = en->load_flags;
+      set_hinting_engines( lib );
+
+      /* hinting programs run when sizes are created, */
+      /* so start over with a fresh face object       */
+      cache_done();
+      FT_Done_Face( *aface );
+
+      error = get_face( aface );
+      if ( error )
+      {
+        *aface = NULL;
+        goto Exit;
+      }
+
+      error = set_face_size( *aface );
+      if ( error )
+      {
+        fprintf( stderr, "failed to set pixel size to %u\n", face_size );
+        goto Exit;
+      }
+
+      cache_init( *aface );
+
+      printf( "\n"
+              "hinting engine `%s':\n",
+              en->name );
+
+      en->first = num_results;
+      run_all( *aface );
+      en->last = num_results;
+    }
+
+    printf( "\n"
+            "cost (us/op) by hinting engine:\n"
+            "\n"
+            "  %-25s", "" );
+    for ( e = 0; e < num_engines; e++ )
+      printf( " %9s", engines[e].name );
+    printf( "\n" );
+
+    for ( k = first; k < engines[0].last; k++ )
+    {
+      const char*  title = results[k].title;
+
+
+      /* each title once */
+      for ( m = first; m < k; m++ )
+        if ( !strcmp( results[m].title, title ) )
+          break;
+      if ( m < k )
+        continue;
+
+      printf( "  %-25s", title );
+      for ( e = 0; e < num_engines; e++ )
+      {
+        double  cost = engine_cost( engines + e, title );
+
+
+        if ( cost > 0.0 )
+          printf( " %9.3f", cost );
+        else
+          printf( " %9s", "-" );
+      }
+      printf( "\n" );
+    }
+
+    /* geometric mean over the tests of the cost ratio to `unhinted' */
+    printf( "\n"
+            "  %-25s", "relative to unhinted" );
+    for ( e = 0; e < num_engines; e++ )
+    {
+      double  sum = 0.0;
+      int     n   = 0;
+
+
+      for ( k = first; k < engines[0].last; k++ )
+      {
+        const char*  title = results[k].title;
+        double       cost  = engine_cost( engines + e, title );
+        double       ref   = engine_cost( engines + num_engines - 1,
+                                          title );
+
+
+        /* each title once */
+        for ( m = first; m < k; m++ )
+          if ( !strcmp( results[m].title, title ) )
+            break;
+
+        if ( m == k && cost > 0.0 && ref > 0.0 )
+        {
+          sum += log( cost / ref );
+          n++;
+        }
+      }
+
+      if ( n )
+        printf( " %8.2fx", exp( sum / n ) );
+      else
+        printf( " %9s", "-" );
+    }
+    printf( "\n" );
+
+  Exit:
+    tt_interpreter_version = saved_version;
+    ps_hinting_engine      = saved_engine;
+    load_flags             = saved_flags;
+    set_hinting_engines( lib );
+
+    return error;
+  }
+
+
+  /*
+   * Cache budget sweep
+   */
+
+#define CACHE_UNLIMITED  ( 1UL << 30 )
+
+  static const char*  cache_names[N_CACHES] = { "Image", "SBit", "CMap" };
+
+
+  /* the results refer to the titles, so keep them (and share them) */
+  static const char*
+  cache_title( int           type,
+               unsigned int  faces,
+               unsigned int  sizes,
+               int           percent )
+  {
+    static char  titles[256][32];
+    static int   num_titles;
+
+    char  bytes[16];
+    char  title[32];
+    int   k;
+
+
+    if ( percent )
+      snprintf( bytes, sizeof ( bytes ), "%d%%", percent );
+    else
+      snprintf( bytes, sizeof ( bytes ), "max" );
+
+    if ( type == CACHE_CMAP )
+      snprintf( title, sizeof ( title ), "%s f=%u b=%s",
+                cache_names[type], faces, bytes );
+    else
+      snprintf( title, sizeof ( title ), "%s f=%u s=%u b=%s",
+                cache_names[type], faces, sizes, bytes );
+
+    for ( k = 0; k < num_titles; k++ )
+      if ( !strcmp( titles[k], title ) )
+        return titles[k];
+
+    if ( num_titles == 256 )
+      return cache_names[type];
+
+    strcpy( titles[num_titles], title );
+
+    return titles[num_titles++];
+  }
+
+
+  /* set up a cache manager with the given limits and one cache */
+  static FT_Error
+  cache_sweep_init( bcachesweep_t*  cs,
+                    unsigned int    faces,
+                    unsigned int    sizes,
+                    FT_ULong        bytes )
+  {
+    FT_Error  error;
+
+
+    error = cache_manager_new( lib,
+                               faces,
+                               sizes,
+                               bytes,
+                               new_face_requester,
+                               NULL,
+                               &cs->manager );
+    if ( error )
+      return error;
+
+    switch ( cs->type )
+    {
+    case CACHE_IMAGE:
+      error = FTC_ImageCache_New( cs->manager, &cs->image_cache );
+      break;
+
+    case CACHE_SBIT:
+      error = FTC_SBitCache_New( cs->manager, &cs->sbit_cache );
+      break;
+
+    default:
+      error = FTC_CMapCache_New( cs->manager, &cs->cmap_cache );
+    }
+
+    if ( error )
+      FTC_Manager_Done( cs->manager );
+
+    return error;
+  }
+
+
+  /* look up every key of the working set once */
+  static void
+  cache_sweep_fill( bcachesweep_t*  cs )
+  {
+    unsigned long  n;
+
+
+    for ( n = 0; n < cs->working_set; n++ )
+    {
+      bcachekey_t  key;
+
+
+      cache_key( cs, n, &key );
+      cache_lookup( cs, &key );
+    }
+  }
+
+
+  /* the live bytes the working set occupies in an unlimited cache, */
+  /* not counting the face and size objects                         */
+  static size_t
+  cache_sweep_footprint( bcachesweep_t*  cs )
+  {
+    size_t        live;
+    unsigned int  f, s;
+
+
+    if ( cache_sweep_init( cs, cs->num_faces, cs->num_faces * cs->num_sizes,
+                           CACHE_UNLIMITED ) )
+      return 0;
+
+    for ( f = 0; f < cs->num_faces; f++ )
+    {
+      FTC_FaceID  face_id = (FTC_FaceID)(size_t)( f + 1 );
+      FT_Face     face;
+
+
+      FTC_Manager_LookupFace( cs->manager, face_id, &face );
+
+      for ( s = 0; s < cs->num_sizes && cs->type != CACHE_CMAP; s++ )
+      {
+        FTC_ScalerRec  scaler;
+        FT_Size        size;
+
+
+        scaler.face_id = face_id;
+        scaler.width   = face_size + s;
+        scaler.height  = face_size + s;
+        scaler.pixel   = 1;
+        scaler.x_res   = 0;
+        scaler.y_res   = 0;
+
+        FTC_Manager_LookupSize( cs->manager, &scaler, &size );
+      }
+    }
+
+    live = mem_stats.live;
+    cache_sweep_fill( cs );
+    live = mem_stats.live - live;
+
+    FTC_Manager_Done( cs->manager );
+
+    return live;
+  }
+
+
+  /* benchmark one set of cache limits; `percent' is relative to the */
+  /* footprint of the working set, with value 0 meaning no limit      */
+  static void
+  cache_sweep_run( FT_Face         face,
+                   bcachesweep_t*  cs,
+                   unsigned int    faces,
+                   unsigned int    sizes,
+                   int             percent,
+                   size_t          footprint )
+  {
+    btest_t   test;
+    FT_ULong  bytes = CACHE_UNLIMITED;
+    int       first = num_results;
+
+
+    if ( percent )
+    {
+      bytes = (FT_ULong)( footprint * (size_t)percent / 100 );
+      if ( !bytes )
+        bytes = 1;        /* zero would select the default */
+    }
+
+    test.title       = cache_title( cs->type, faces, sizes, percent );
+    test.bench       = test_cache_lookup;
+    test.cache_first = 0;
+    test.user_data   = (void*)cs;
+
+    if ( cache_sweep_init( cs, faces, sizes, bytes ) )
+    {
+      fail( &test, "couldn't create cache" );
+
+      return;
+    }
+
+    cache_sweep_fill( cs );
+
+    cs->hits   = 0;
+    cs->misses = 0;
+
+    benchmark( face, &test );
+
+    add_hits( first, cs->hits, cs->misses );
+
+    FTC_Manager_Done( cs->manager );
+  }
+
+
+  static int
+  compare_ulongs( const void*  a,
+                  const void*  b )
+  {
+    FT_ULong  x = *(const FT_ULong*)a;
+    FT_ULong  y = *(const FT_ULong*)b;
+
+
+    return x < y ? -1 : x > y;
+  }
+
+
+  /* set up `codes' as the distinct values of `seq' and `sequence' as */
+  /* the positions of the elements of `seq' in `codes'                */
+  static void
+  cache_sweep_replay( bcachesweep_t*   cs,
+                      const FT_ULong*  seq,
+                      int              count )
+  {
+    int  k, n;
+
+
+    cs->codes    = (FT_ULong*)malloc( (size_t)count * sizeof ( FT_ULong ) );
+    cs->sequence = (unsigned int*)malloc( (size_t)count *
+                                            sizeof ( unsigned int ) );
+    if ( !cs->codes || !cs->sequence || !count )
+    {
+      free( cs->codes );
+      free( cs->sequence );
+      cs->codes       = NULL;
+      cs->sequence    = NULL;
+      cs->num_indices = 0;
+
+      return;
+    }
+
+    memcpy( cs->codes, seq, (size_t)count * sizeof ( FT_ULong ) );
+    qsort( cs->codes, (size_t)count, sizeof ( FT_ULong ), compare_ulongs );
+
+    for ( k = 1, n = 1; k < count; k++ )
+      if ( cs->codes[k] != cs->codes[n - 1] )
+        cs->codes[n++] = cs->codes[k];
+
+    for ( k = 0; k < count; k++ )
+    {
+      FT_ULong*  found = (FT_ULong*)bsearch( seq + k,
+                                             cs->codes,
+                                             (size_t)n,
+                                             sizeof ( FT_ULong ),
+                                             compare_ulongs );
+
+
+      cs->sequence[k] = (unsigned int)( found - cs->codes );
+    }
+
+    cs->num_indices  = (unsigned int)n;
+    cs->num_sequence = count;
+    cs->pos          = 0;
+  }
+
+
+  /* run all caches with shrinking limits on faces, sizes, and bytes */
+  static void
+  run_cache_sweep( FT_Face  face )
+  {
+    bcachesweep_t  cs;
+    bcharset_t     charset;
+    int            t;
+
+
+    if ( !face_size )
+    {
+      printf( "  cache sweep disabled (size = 0)\n" );
+
+      return;
+    }
+
+    charset.size = 0;
+    get_charset( face, &charset );
+
+    cs.num_faces = (unsigned int)cache_faces;
+    cs.first     = first_index < last_index ? first_index : last_index;
+
+    for ( t = 0; t < N_CACHES; t++ )
+    {
+      unsigned int  all_sizes;
+      unsigned int  n;
+      size_t        footprint;
+
+
+      cs.type     = t;
+      cs.codes    = NULL;
+      cs.sequence = NULL;
+
+      /* bitmap-only fonts have a single usable size */
+      cs.num_sizes = t == CACHE_CMAP || !FT_IS_SCALABLE( face )
+                       ? 1
+                       : (unsigned int)cache_sizes;
+
+      /* replay the text order, with repeats */
+      if ( t == CACHE_CMAP && workload_chars )
+        cache_sweep_replay( &cs, workload_chars, num_workload_chars );
+      else if ( t == CACHE_CMAP )
+      {
+        cs.codes       = charset.code;
+        cs.num_indices = (unsigned int)charset.size;
+      }
+      else if ( workload )
+      {
+        FT_ULong*  glyphs;
+        int        k;
+
+
+        glyphs = (FT_ULong*)malloc( ( (size_t)num_workload + 1 ) *
+                                      sizeof ( FT_ULong ) );
+        if ( !glyphs )
+          continue;
+
+        for ( k = 0; k < num_workload; k++ )
+          glyphs[k] = workload[k];
+
+        cache_sweep_replay( &cs, glyphs, num_workload );
+        free( glyphs );
+      }
+      else
+        cs.num_indices = first_index < last_index
+                           ? last_index - first_index + 1
+                           : first_index - last_index + 1;
+
+      if ( !cs.num_indices )
+        continue;
+
+      cs.working_set = (unsigned long)cs.num_faces * cs.num_sizes *
+                       cs.num_indices;
+      cs.num_lookups = cs.working_set < MAX_LOOKUPS ? (int)cs.working_set
+                                                    : MAX_LOOKUPS;
+      cs.seed        = 2463534242UL;
+
+      all_sizes = cs.num_faces * cs.num_sizes;
+      footprint = cache_sweep_footprint( &cs );
+
+      if ( t == CACHE_CMAP )
+        printf( "\n"
+                "%s cache, %u face(s) x %u characters"
+                " (%lu bytes):\n",
+                cache_names[t],
+                cs.num_faces,
+                cs.num_indices,
+                (unsigned long)footprint );
+      else
+        printf( "\n"
+                "%s cache, %u face(s) x %u size(s) x %u glyphs"
+                " (%lu bytes):\n",
+                cache_names[t],
+                cs.num_faces,
+                cs.num_sizes,
+                cs.num_indices,
+                (unsigned long)footprint );
+
+      /* everything resident first */
+      cache_sweep_run( face, &cs, cs.num_faces, all_sizes, 0, footprint );
+
+      for ( n = cs.num_faces / 2; n > 0; n /= 2 )
+        cache_sweep_run( face, &cs, n, all_sizes, 0, footprint );
+
+      if ( t != CACHE_CMAP )
+        for ( n = all_sizes / 2; n > 0; n /= 2 )
+          cache_sweep_run( face, &cs, cs.num_faces, n, 0, footprint );
+
+      for ( n = 50; n > 5; n /= 2 )
+        cache_sweep_run( face, &cs, cs.num_faces, all_sizes, (int)n,
+                         footprint );
+
+      if ( cs.sequence )
+      {
+        free( cs.codes );
+        free( cs.sequence );
+      }
+    }
+
+    free( charset.code );
+  }
+
+
+  /* parse `FxS', the faces and sizes of the cache sweep working set */
+  static void
+  parse_cache_sweep( const char*  arg )
+  {
+    char*  end;
+
+
+    cache_faces = (int)strtol( arg, &end, 10 );
+    cache_sizes = 1;
+    if ( *end == 'x' )
+      cache_sizes = (int)strtol( end + 1, &end, 10 );
+
+    if ( *end || cache_faces < 1 || cache_sizes < 1 )
+    {
+      fprintf( stderr, "warning: couldn't parse `%s'\n", arg );
+      cache_faces = 0;
+
+      return;
+    }
+
+    /* the working set must still fit into memory */
+    if ( cache_faces > 16 )
+      cache_faces = 16;
+    if ( cache_sizes > 16 )
+      cache_sizes = 16;
+  }
+
+
+  static void
+  print_workload( void )
+  {
+    if ( !workload_chars )
+      return;
+
+    printf( "\n"
+            "workload: %d glyphs (%d distinct) for %d characters",
+            num_workload,
+            num_workload_distinct,
+            num_workload_chars );
+    if ( num_workload < num_workload_chars )
+      printf( ", %d not covered", num_workload_chars - num_workload );
+    printf( "\n" );
+  }
+
+
+  static void
+  print_settings( void )
+  {
+    printf( "\n" );
+    if ( max_iter )
+      printf( "number of iterations for each test: at most %d\n",
+              max_iter );
+    printf( "number of seconds for each test: %s%f\n",
+             max_iter ? "at most " : "",
+             max_time );
+    if ( warmup_iter )
+      printf( "number of warm-up iterations for each test: %d\n",
+              warmup_iter );
+    if ( target_error > 0 )
+      printf( "target relative error (95%% confidence): %g%%\n",
+              target_error );
+    if ( num_threads > 1 )
+      printf( "number of threads: %d (timing wall-clock time)\n",
+              num_threads );
+
+    if ( last_index == ~0U )
+      printf( "\n"
+              "glyph indices: from %u to the last one\n",
+              first_index );
+    else
+      printf( "\n"
+              "glyph indices: from %u to %u\n",
+              first_index,
+              last_index );
+    if ( num_sweep_sizes )
+    {
+      int  k;
+
+
+      printf( "face sizes:" );
+      for ( k = 0; k < num_sweep_sizes; k++ )
+        printf( "%s %u", k ? "," : "", sweep_sizes[k] );
+      printf( "ppem\n" );
+    }
+    else
+      printf( "face size: %uppem\n",
+              face_size );
+    if ( stream_mode )
+    {
+      printf( "font access: custom stream, %luus per read, ",
+              stream_latency );
+      if ( stream_chunk )
+        printf( "chunks of %lu bytes\n", stream_chunk );
+      else
+        printf( "reads as requested\n" );
+    }
+    else
+      printf( "font preloading into memory: %s\n",
+              preload == 2 ? "yes (mmap)" : preload ? "yes" : "no" );
+    if ( zipf_exponent > 0 )
+      printf( "text workload: Zipf distribution (exponent %g)\n",
+              zipf_exponent );
+    else if ( workload_name )
+      printf( "text workload: `%s'%s\n",
+              workload_name,
+              workload_counts ? " (frequency table)" : "" );
+    if ( cold_start )
+      printf( "cold start: font file dropped from page cache"
+              " before every iteration\n"
+              "            (timing wall-clock time)\n" );
+#ifdef BENCH_SAMPLER
+    if ( sample_test >= 0 )
+      printf( "sampling profiler: test `%c', every %dus of CPU time\n",
+              'a' + sample_test,
+              SAMPLE_INTERVAL );
+#endif
+    if ( engine_matrix )
+      printf( "engine matrix: all hinting engines, autohinter, unhinted\n" );
+    if ( render_matrix )
+      printf( "render matrix: all render modes by all LCD filters\n" );
+    if ( use_lcd_weights )
+      printf( "LCD filter weights: %d,%d,%d,%d,%d\n",
+              lcd_weights[0], lcd_weights[1], lcd_weights[2],
+              lcd_weights[3], lcd_weights[4] );
+    if ( share_threads )
+      printf( "shared cache contention: %d thread(s)"
+              " (timing wall-clock time)\n",
+              share_threads );
+    if ( cache_faces )
+      printf( "cache sweep working set: %d face(s) x %d size(s)\n",
+              cache_faces,
+              cache_sizes );
+
+    printf( "\n"
+            "load flags: 0x%X\n"
+            "render mode: %u\n",
+            load_flags,
+            render_mode );
+    printf( "\n"
+            "CFF hinting engine set to `%s'\n"
+            "TrueType interpreter set to version %u\n"
+            "maximum cache size: %luKiByte\n",
+            ps_hinting_engine_names[ps_hinting_engine],
+            tt_interpreter_version,
+            max_bytes / 1024 );
+  }
+
+
+  /*
+   * Cold start: time to the first glyph with the font file evicted from
+   * the page cache, for three ways of loading it
+   */
+
+#ifdef BENCH_COLD
+
+  enum {
+    COLD_FILE,       /* `FT_New_Face' */
+    COLD_PRELOAD,    /* `fread' and `FT_New_Memory_Face' */
+    COLD_MMAP,       /* `mmap' and `FT_New_Memory_Face' */
+    N_COLD_PATHS
+  };
+
+  enum {
+    COLD_OPEN,       /* open the face and set the size */
+    COLD_CMAP,       /* first `FT_Get_Char_Index' */
+    COLD_LOAD,       /* first `FT_Load_Glyph' */
+    COLD_RENDER,     /* first `FT_Render_Glyph' */
+    N_COLD_PHASES
+  };
+
+
+  static const char*  cold_paths[N_COLD_PATHS] =
+  {
+    "file",
+    "preload",
+    "mmap"
+  };
+
+  static const char*  cold_phases[N_COLD_PHASES] =
+  {
+    "open",
+    "cmap",
+    "load",
+    "render"
+  };
+
+
+  typedef struct  bcold_t_
+  {
+    int       path;
+    int       phase;       /* the phase to time; the others are untimed */
+    FT_ULong  charcode;    /* the character to look up first          */
+
+  } bcold_t;
+
+
+  static int
+  drop_file( const char*  name )
+  {
+    int  fd = open( name, O_RDONLY );
+    int  error;
+
+
+    if ( fd < 0 )
+      return 1;
+
+    error = posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+    close( fd );
+
+    return error;
+  }
+
+
+  static FT_Error
+  cold_open( int       path,
+             bfile_t*  file,
+             FT_Face*  aface )
+  {
+    FT_Error  error;
+
+
+    if ( path == COLD_FILE )
+      error = FT_New_Face( lib, filename, face_index, aface );
+    else
+    {
+      if ( file_load( filename, path == COLD_MMAP, file ) )
+        return FT_Err_Cannot_Open_Resource;
+
+      error = FT_New_Memory_Face( lib,
+                                  file->base,
+                                  (FT_Long)file->size,
+                                  face_index,
+                                  aface );
+    }
+
+    if ( !error )
+    {
+      error = set_face_size( *aface );
+      if ( error )
+      {
+        FT_Done_Face( *aface );
+        *aface = NULL;
+      }
+    }
+
+    return error;
+  }
+
+
+  /* every iteration starts from scratch with the file evicted */
+  static int
+  test_cold( btimer_t*  timer,
+             FT_Face    face,
+             void*      user_data )
+  {
+    bcold_t*  cold      = (bcold_t*)user_data;
+    FT_Face   cold_face = NULL;
+    bfile_t   file;
+    FT_UInt   gindex    = 0;
+    FT_Error  error     = FT_Err_Ok;
+    int       phase;
+    int       done      = 0;
+
+    FT_UNUSED( face );
+
+
+    file.base = NULL;
+
+    if ( drop_file( filename ) )
+      return 0;
+
+    for ( phase = 0; phase <= cold->phase && !error; phase++ )
+    {
+      if ( phase == cold->phase )
+        TIMER_START( timer );
+
+      switch ( phase )
+      {
+      case COLD_OPEN:
+        error = cold_open( cold->path, &file, &cold_face );
+        break;
+
+      case COLD_CMAP:
+        gindex = FT_Get_Char_Index( cold_face, cold->charcode );
+        break;
+
+      case COLD_LOAD:
+        error = FT_Load_Glyph( cold_face, gindex, load_flags );
+        break;
+
+      default:
+        error = FT_Render_Glyph( cold_face->glyph, render_mode );
+      }
+
+      if ( phase == cold->phase )
+      {
+        TIMER_STOP( timer );
+
+        done = !error;
+      }
+    }
+
+    if ( cold_face )
+      FT_Done_Face( cold_face );
+    if ( file.base )
+      file_unload( &file );
+
+    return done;
+  }
+
+
+  /* the character that a text would most likely start with */
+  static FT_ULong
+  cold_charcode( FT_Face  face )
+  {
+    FT_UInt  gindex;
+
+
+    if ( workload_chars )
+      return workload_chars[0];
+
+    if ( FT_Get_Char_Index( face, 'a' ) )
+      return 'a';
+
+    return FT_Get_First_Char( face, &gindex );
+  }
+
+
+  static void
+  run_cold_start( FT_Face  face )
+  {
+    bcold_t  cold;
+    btest_t  test;
+    int      first = num_results;
+    int      path, phase;
+
+    static char  titles[N_COLD_PATHS][N_COLD_PHASES][32];
+
+
+    cold.charcode = cold_charcode( face );
+
+    test.bench       = test_cold;
+    test.cache_first = 0;
+    test.user_data   = (void*)&cold;
+
+    for ( path = 0; path < N_COLD_PATHS; path++ )
+    {
+      for ( phase = 0; phase < N_COLD_PHASES; phase++ )
+      {
+        snprintf( titles[path][phase], sizeof ( titles[path][phase] ),
+                  "Cold %s (%s)",
+                  cold_phases[phase],
+                  cold_paths[path] );
+
+        cold.path  = path;
+        cold.phase = phase;
+
+        test.title = titles[path][phase];
+        if ( phase == COLD_RENDER && !face_size )
+          skip( &test, "disabled (size = 0)" );
+        else
+          benchmark( face, &test );
+      }
+    }
+
+    /* the phases are timed in separate runs; their sum is the */
+    /* time to the first glyph                                  */
+    printf( "\n"
+            "time to first glyph (us):\n"
+            "\n"
+            "  %-10s", "" );
+    for ( phase = 0; phase < N_COLD_PHASES; phase++ )
+      printf( " %10s", cold_phases[phase] );
+    printf( " %10s\n", "total" );
+
+    for ( path = 0; path < N_COLD_PATHS; path++ )
+    {
+      double  total = 0.0;
+
+
+      printf( "  %-10s", cold_paths[path] );
+
+      for ( phase = 0; phase < N_COLD_PHASES; phase++ )
+      {
+        int  k;
+
+
+        for ( k = first; k < num_results; k++ )
+          if ( results[k].title == titles[path][phase] )
+            break;
+
+        if ( k < num_results && results[k].done )
+        {
+          double  t = results[k].total / results[k].done;
+
+
+          printf( " %10.1f", t );
+          total += t;
+        }
+        else
+          printf( " %10s", "-" );
+      }
+      printf( " %10.1f\n", total );
+    }
+  }
+
+#endif /* BENCH_COLD */
+
+
+  /*
+   * Shared cache contention: the cache lookups of tests `e' to `g' (image,
+   * sbit, and cmap cache) in several threads, sharing one locked cache
+   * manager, spreading the keys over several locked cache managers, or
+   * using one cache manager per thread
+   */
+
+#ifdef BENCH_THREADS
+
+  enum {
+    SHARE_LOCKED,
+    SHARE_SHARDED,
+    SHARE_PRIVATE,
+    N_SHARE_MODES
+  };
+
+  static const char*  share_names[N_SHARE_MODES] =
+  {
+    "locked",
+    "sharded",
+    "per-thread"
+  };
+
+
+  /* a cache manager with its own library and face */
+  typedef struct  bshard_t_
+  {
+    pthread_mutex_t       lock;
+    struct FT_MemoryRec_  memory;
+    bmemstats_t           stats;
+    size_t                base;     /* live bytes before the caches */
+    FT_Library            library;
+    FT_Face               face;
+    FTC_Manager           manager;
+    FTC_ImageCache        image_cache;
+    FTC_SBitCache         sbit_cache;
+    FTC_CMapCache         cmap_cache;
+    FTC_ImageTypeRec      type;
+
+  } bshard_t;
+
+
+  typedef struct  bshare_t_
+  {
+    int              mode;
+    int              type;      /* `CACHE_XXX' */
+    bshard_t*        shards;
+    int              num_shards;
+    bcharset_t*      charset;
+
+    pthread_mutex_t  sync_mutex;
+    pthread_cond_t   sync_cond;
+    int              sync_count;
+    int              sync_failed;   /* not all threads were started */
+
+  } bshare_t;
+
+
+  typedef struct  bsharethread_t_
+  {
+    pthread_t      id;
+    bshare_t*      share;
+    int            index;
+    unsigned long  ops;
+    double         time;
+
+  } bsharethread_t;
+
+
+  static FT_Error
+  shard_init( bshard_t*  shard )
+  {
+    FT_Library  saved = lib;
+    FT_Error    error;
+
+
+    error = library_new( &shard->memory, &shard->stats, &shard->library );
+    if ( error )
+      return error;
+
+    /* `get_face' opens the face in the library of the current thread */
+    lib   = shard->library;
+    error = get_face( &shard->face );
+    lib   = saved;
+    if ( error )
+      return error;
+
+    error = set_face_size( shard->face );
+    if ( error )
+      return error;
+
+    shard->base = shard->stats.live;
+
+    error = cache_manager_new( shard->library,
+                               0,
+                               0,
+                               max_bytes,
+                               face_requester,
+                               shard->face,
+                               &shard->manager );
+    if ( !error )
+      error = FTC_ImageCache_New( shard->manager, &shard->image_cache );
+    if ( !error )
+      error = FTC_SBitCache_New( shard->manager, &shard->sbit_cache );
+    if ( !error )
+      error = FTC_CMapCache_New( shard->manager, &shard->cmap_cache );
+    if ( error )
+      return error;
+
+    shard->type.face_id = (FTC_FaceID)1;
+    shard->type.width   = face_size;
+    shard->type.height  = face_size;
+    shard->type.flags   = load_flags;
+
+    pthread_mutex_init( &shard->lock, NULL );
+
+    return FT_Err_Ok;
+  }
+
+
+  static void
+  shard_done( bshard_t*  shard )
+  {
+    if ( shard->manager )
+    {
+      FTC_Manager_Done( shard->manager );
+      pthread_mutex_destroy( &shard->lock );
+    }
+
+    /* this also releases the face */
+    if ( shard->library )
+      FT_Done_Library( shard->library );
+  }
+
+
+  static void
+  share_lookup( bshare_t*  share,
+                int        thread,
+                FT_ULong   key )
+  {
+    bshard_t*  shard;
+
+
+    if ( share->mode == SHARE_LOCKED )
+      shard = share->shards;
+    else if ( share->mode == SHARE_SHARDED )
+      shard = share->shards + key % (FT_ULong)share->num_shards;
+    else
+      shard = share->shards + thread;
+
+    if ( share->mode != SHARE_PRIVATE )
+      pthread_mutex_lock( &shard->lock );
+
+    if ( share->type == CACHE_IMAGE )
+    {
+      FT_Glyph  glyph;
+
+
+      FTC_ImageCache_Lookup( shard->image_cache,
+                             &shard->type,
+                             (FT_UInt)key,
+                             &glyph,
+                             NULL );
+    }
+    else if ( share->type == CACHE_SBIT )
+    {
+      FTC_SBit  sbit;
+
+
+      FTC_SBitCache_Lookup( shard->sbit_cache,
+                            &shard->type,
+                            (FT_UInt)key,
+                            &sbit,
+                            NULL );
+    }
+    else
+      FTC_CMapCache_Lookup( shard->cmap_cache,
+                            shard->type.face_id,
+                            0,
+                            key );
+
+    if ( share->mode != SHARE_PRIVATE )
+      pthread_mutex_unlock( &shard->lock );
+  }
+
+
+  /* look up all glyphs (or characters) once */
+  static unsigned long
+  share_pass( bshare_t*  share,
+              int        thread )
+  {
+    unsigned long  ops = 0;
+    unsigned int   i;
+    int            k;
+
+
+    if ( share->type == CACHE_CMAP )
+    {
+      for ( k = 0; k < share->charset->size; k++, ops++ )
+        share_lookup( share, thread, share->charset->code[k] );
+    }
+    else
+    {
+      FOREACH( i )
+      {
+        share_lookup( share, thread, i );
+        ops++;
+      }
+    }
+
+    return ops;
+  }
+
+
+  /* return non-zero if the run has been abandoned */
+  static int
+  share_sync( bshare_t*  share )
+  {
+    int  failed;
+
+
+    pthread_mutex_lock( &share->sync_mutex );
+
+    if ( ++share->sync_count == share_threads )
+      pthread_cond_broadcast( &share->sync_cond );
+    else
+      while ( share->sync_count < share_threads && !share->sync_failed )
+        pthread_cond_wait( &share->sync_cond, &share->sync_mutex );
+
+    failed = share->sync_failed;
+
+    pthread_mutex_unlock( &share->sync_mutex );
+
+    return failed;
+  }
+
+
+  static void*
+  share_thread( void*  arg )
+  {
+    bsharethread_t*  thread = (bsharethread_t*)arg;
+    bshare_t*        share  = thread->share;
+    double           t0;
+
+
+    /* fill the caches before the clock starts */
+    share_pass( share, thread->index );
+    if ( share_sync( share ) )
+      return NULL;
+
+    t0 = get_time();
+    do
+    {
+      thread->ops += share_pass( share, thread->index );
+      thread->time = get_time() - t0;
+
+    } while ( thread->time < 1E6 * max_time );
+
+    return NULL;
+  }
+
+
+  static void
+  run_share( FT_Face  face )
+  {
+    bcharset_t  charset;
+    bshare_t    share;
+    int         t, m, n;
+
+
+    charset.code = NULL;
+    charset.size = 0;
+    get_charset( face, &charset );
+
+    share.charset = &charset;
+
+    printf( "\n"
+            "cache lookups in %d threads:\n"
+            "\n"
+            "  %-18s %12s %10s %10s %10s\n",
+            share_threads,
+            "", "ops/s", "us/op", "KiB", "cache KiB" );
+
+    for ( t = 0; t < N_CACHES; t++ )
+    {
+      for ( m = 0; m < N_SHARE_MODES; m++ )
+      {
+        bsharethread_t*  threads;
+        unsigned long    ops    = 0;
+        double           rate   = 0.0;
+        double           time   = 0.0;
+        size_t           memory = 0;
+        size_t           cached = 0;
+        int              started;
+        FT_Error         error  = FT_Err_Ok;
+
+
+        printf( "  %-5s %-12s", cache_names[t], share_names[m] );
+        fflush( stdout );
+
+        if ( t != CACHE_CMAP && !face_size )
+        {
+          printf( " disabled (size = 0)\n" );
+          continue;
+        }
+        if ( t == CACHE_CMAP && !charset.size )
+        {
+          printf( " no characters\n" );
+          continue;
+        }
+
+        share.mode       = m;
+        share.type       = t;
+        share.num_shards = m == SHARE_LOCKED ? 1 : share_threads;
+        share.sync_count  = 0;
+        share.sync_failed = 0;
+        pthread_mutex_init( &share.sync_mutex, NULL );
+        pthread_cond_init( &share.sync_cond, NULL );
+
+        share.shards  = (bshard_t*)calloc( (size_t)share.num_shards,
+                                           sizeof ( bshard_t ) );
+        threads       = (bsharethread_t*)calloc( (size_t)share_threads,
+                                                 sizeof ( bsharethread_t ) );
+        if ( !share.shards || !threads )
+          error = FT_Err_Out_Of_Memory;
+
+        for ( n = 0; !error && n < share.num_shards; n++ )
+          error = shard_init( share.shards + n );
+
+        for ( started = 0; !error && started < share_threads; started++ )
+        {
+          threads[started].share = &share;
+          threads[started].index = started;
+
+          if ( pthread_create( &threads[started].id, NULL,
+                               share_thread, threads + started ) )
+            break;
+        }
+
+        /* release the started threads waiting for the missing ones */
+        if ( !error && started < share_threads )
+        {
+          pthread_mutex_lock( &share.sync_mutex );
+          share.sync_failed = 1;
+          pthread_cond_broadcast( &share.sync_cond );
+          pthread_mutex_unlock( &share.sync_mutex );
+
+          fprintf( stderr, "couldn't create thread\n" );
+          error = FT_Err_Invalid_Argument;
+        }
+
+        for ( n = 0; n < started; n++ )
+        {
+          pthread_join( threads[n].id, NULL );
+
+          ops  += threads[n].ops;
+          time += threads[n].time;
+          if ( threads[n].time > 0.0 )
+            rate += 1E6 * threads[n].ops / threads[n].time;
+        }
+
+        for ( n = 0; share.shards && n < share.num_shards; n++ )
+        {
+          memory += share.shards[n].stats.live;
+          cached += share.shards[n].stats.live - share.shards[n].base;
+
+          shard_done( share.shards + n );
+        }
+
+        if ( error )
+          printf( " failed\n" );
+        else
+          printf( " %12.0f %10.3f %10.0f %10.0f\n",
+                  rate,
+                  ops ? time / (double)ops : 0.0,
+                  (double)memory / 1024,
+                  (double)cached / 1024 );
+
+        free( share.shards );
+        free( threads );
+
+        pthread_cond_destroy( &share.sync_cond );
+        pthread_mutex_destroy( &share.sync_mutex );
+      }
+    }
+
+    free( charset.code );
+  }
+
+#endif /* BENCH_THREADS */
+
+
+  /*
+   * Run all tests on face `face_index' of `filename'; in corpus mode, print
+   * a short header only
+   */
+
+  static FT_Error
+  bench_face( int  corpus )
+  {
+    FT_Face   face;
+    FT_Error  error;
+    int       first_result = num_results;
+    size_t    i;
+
+
+    error = get_face( &face );
+    if ( error )
+      return error;
+
+    font_format = FT_Get_Font_Format( face );
+    font_driver = (*(FT_Module_Class**)( face->driver ))->module_name;
+
+    first_index = first_index_arg;
+    last_index  = last_index_arg;
+    if ( first_index >= (unsigned int)face->num_glyphs )
+      first_index = (unsigned int)face->num_glyphs - 1;
+    if ( last_index  >= (unsigned int)face->num_glyphs )
+      last_index  = (unsigned int)face->num_glyphs - 1;
+    incr_index  = last_index > first_index ? 1 : -1;
+
+    face_size = face_size_arg;
+    if ( face_size && !FT_IS_SCALABLE( face ) )
+    {
+      face_size = (unsigned int)face->available_sizes[0].size >> 6;
+      if ( !corpus )
+        fprintf( stderr,
+                 "using size of first bitmap strike (%upx)\n", face_size );
+    }
+
+    error = set_face_size( face );
+    if ( error )
+    {
+      fprintf( stderr, "failed to set pixel size to %u\n", face_size );
+      FT_Done_Face( face );
+
+      return error;
+    }
+
+    cache_init( face );
+
+    if ( workload_name || zipf_exponent > 0 )
+      workload_init( face );
+
+    if ( corpus )
+    {
+      printf( "\n"
+              "font `%s', face %ld, instance %ld: %s %s (%s)\n",
+              filename,
+              face_index & 0xFFFF,
+              face_index >> 16,
+              face->family_name ? face->family_name : "(unknown)",
+              face->style_name ? face->style_name : "",
+              font_format );
+      print_workload();
+    }
+    else
+    {
+      printf( "\n"
+              "ftbench results for font `%s'\n"
+              "---------------------------",
+              filename );
+      for ( i = 0; i < strlen( filename ); i++ )
+        putchar( '-' );
+      putchar( '\n' );
+
+      printf( "\n"
+              "family: %s\n"
+              " style: %s\n",
+              face->family_name,
+              face->style_name );
+
+      print_settings();
+      print_workload();
+
+      printf( "\n"
+              "executing tests:\n" );
+    }
 
-    FT_UNUSED( face );
-    FT_UNUSED( user_data );
+    if ( stream_mode )
+      run_stream_profile();
 
+    if ( cache_faces )
+      run_cache_sweep( face );
+#ifdef BENCH_COLD
+    else if ( cold_start )
+      run_cold_start( face );
+#endif
+#ifdef BENCH_THREADS
+    else if ( share_threads )
+      run_share( face );
+#endif
+    else if ( engine_matrix )
+    {
+      error = run_engine_matrix( &face );
+      if ( !face )
+      {
+        workload_done();
 
-    TIMER_START( timer );
+        return error;
+      }
+    }
+    else if ( render_matrix )
+    {
+      error = run_render_matrix( &face );
+      if ( !face )
+      {
+        workload_done();
 
-    if ( !get_face( &bench_face ) )
-      FT_Done_Face( bench_face );
+        return error;
+      }
+    }
+    else if ( num_sweep_sizes && FT_IS_SCALABLE( face ) )
+    {
+      int  k;
 
-    TIMER_STOP( timer );
 
-    return 1;
-  }
+      for ( k = 0; k < num_sweep_sizes; k++ )
+      {
+        /* the cache manager may destroy size objects it has used, */
+        /* so start over with a fresh face object for every size   */
+        cache_done();
+        if ( k )
+        {
+          FT_Done_Face( face );
 
+          error = get_face( &face );
+          if ( error )
+          {
+            workload_done();
 
-  static int
-  test_new_face_and_load_glyph( btimer_t*  timer,
-                                FT_Face    face,
-                                void*      user_data )
-  {
-    FT_Face  bench_face;
+            return error;
+          }
+        }
 
-    unsigned int  i;
-    int           done = 0;
+        face_size = sweep_sizes[k];
+        if ( set_face_size( face ) )
+        {
+          fprintf( stderr, "failed to set pixel size to %u\n", face_size );
+          continue;
+        }
 
-    FT_UNUSED( face );
-    FT_UNUSED( user_data );
+        cache_init( face );
 
+        printf( "\n"
+                "face size %uppem:\n",
+                face_size );
 
-    TIMER_START( timer );
+        run_all( face );
+      }
 
-    if ( !get_face( &bench_face ) )
+      print_sweep( first_result );
+    }
+    else
     {
-      FOREACH( i )
-      {
-        if ( !FT_Load_Glyph( bench_face, i, load_flags ) )
-          done++;
-      }
+      if ( num_sweep_sizes && !corpus )
+        fprintf( stderr, "size sweep disabled for bitmap-only font\n" );
 
-      FT_Done_Face( bench_face );
+      run_all( face );
     }
 
-    TIMER_STOP( timer );
+    workload_done();
+    cache_done();
+    FT_Done_Face( face );
 
-    return done;
+    return FT_Err_Ok;
   }
 
 
   /*
-   * main
+   * Baselines
    */
 
+  typedef struct  bbaseline_t_
+  {
+    char    key[1024];
+    int     count;
+    double  mean;
+    double  stddev;
+
+  } bbaseline_t;
+
+
+  /* results of different runs are matched by test, font, and settings; */
+  /* the font is identified by its path as given on the command line,  */
+  /* since different directories can hold files of the same name       */
   static void
-  get_charset( FT_Face      face,
-               bcharset_t*  charset )
+  get_result_key( bresult_t*  r,
+                  char*       key,
+                  size_t      size )
   {
-    FT_ULong  charcode;
-    FT_UInt   gindex;
-    int       i = 0;
+    snprintf( key, size, "%c\t%s\t%s\t%ld\t%u\t0x%X\t%d\t%u\t%u",
+              r->test >= 0 ? 'a' + r->test : '-',
+              r->title,
+              r->font,
+              r->face_index,
+              r->size,
+              r->load_flags,
+              r->render_mode,
+              r->tt_interpreter_version,
+              r->ps_hinting_engine );
+  }
 
 
-    charset->code = (FT_ULong*)calloc( (size_t)face->num_glyphs,
-                                       sizeof ( FT_ULong ) );
-    if ( !charset->code )
-      return;
+  static void
+  save_baseline( const char*  name )
+  {
+    FILE*  file;
+    char   key[1024];
+    int    k;
 
-    if ( face->charmap )
+
+    file = fopen( name, "w" );
+    if ( !file )
     {
-      charcode = FT_Get_First_Char( face, &gindex );
+      fprintf( stderr, "couldn't open `%s' for writing\n", name );
 
-      /* certain fonts contain a broken charmap that will map character */
-      /* codes to out-of-bounds glyph indices.  Take care of that here. */
-      /*                                                                */
-      while ( gindex && i < face->num_glyphs )
-      {
-        if ( ( first_index <= gindex && gindex <= last_index ) ||
-             ( first_index >= gindex && gindex >= last_index ) )
-          charset->code[i++] = charcode;
-        charcode = FT_Get_Next_Char( face, charcode, &gindex );
-      }
+      return;
     }
-    else
+
+    fprintf( file, "# ftbench baseline\n"
+                   "# test, title, font, face index, size, load flags,"
+                   " render mode, TT interpreter, PS hinting engine,"
+                   " samples, mean, stddev\n" );
+
+    for ( k = 0; k < num_results; k++ )
     {
-      unsigned int  j;
+      bresult_t*  r = results + k;
 
 
-      /* no charmap, do an identity mapping */
-      FOREACH( j )
-        charset->code[i++] = j;
+      if ( !r->done )
+        continue;
+
+      get_result_key( r, key, sizeof ( key ) );
+      fprintf( file, "%s\t%d\t%.6f\t%.6f\n",
+               key,
+               r->stats.count,
+               r->stats.mean,
+               r->stats.stddev );
     }
 
-    charset->size = i;
+    fclose( file );
   }
 
 
-  static FT_Error
-  get_face( FT_Face*  face )
+  static bbaseline_t*
+  load_baseline( const char*  name,
+                 int*         acount )
   {
-    static unsigned char*  memory_file = NULL;
-    static size_t          memory_size;
-    int                    face_index = 0;
-    FT_Error               error;
+    FILE*         file;
+    bbaseline_t*  base  = NULL;
+    int           count = 0, max = 0;
+    char          line[1024];
+
 
+    *acount = 0;
 
-    if ( preload )
+    file = fopen( name, "r" );
+    if ( !file )
     {
-      if ( !memory_file )
-      {
-        FILE*  file = fopen( filename, "rb" );
+      fprintf( stderr, "couldn't open baseline `%s'\n", name );
 
+      return NULL;
+    }
 
-        if ( file == NULL )
-        {
-          fprintf( stderr, "couldn't find or open `%s'\n", filename );
+    while ( fgets( line, sizeof ( line ), file ) )
+    {
+      char*  p;
+      int    tabs;
 
-          return 1;
-        }
 
-        fseek( file, 0, SEEK_END );
-        memory_size = (size_t)ftell( file );
-        fseek( file, 0, SEEK_SET );
+      if ( line[0] == '#' )
+        continue;
 
-        memory_file = (FT_Byte*)malloc( memory_size );
-        if ( memory_file == NULL )
-        {
-          fprintf( stderr,
-                   "couldn't allocate memory to pre-load font file\n" );
+      /* the key consists of the first nine fields */
+      for ( p = line, tabs = 0; *p && tabs < 9; p++ )
+        if ( *p == '\t' )
+          tabs++;
+      if ( tabs < 9 )
+        continue;
 
-          return 1;
-        }
+      if ( count == max )
+      {
+        bbaseline_t*  new_base;
 
-        if ( !fread( memory_file, memory_size, 1, file ) )
-        {
-          fprintf( stderr, "read error\n" );
-          free( memory_file );
-          memory_file = NULL;
 
-          return 1;
-        }
+        max      = max ? 2 * max : 64;
+        new_base = (bbaseline_t*)realloc( base,
+                                          (size_t)max *
+                                            sizeof ( bbaseline_t ) );
+        if ( !new_base )
+          break;
+        base = new_base;
       }
 
-      error = FT_New_Memory_Face( lib,
-                                  memory_file,
-                                  (FT_Long)memory_size,
-                                  face_index,
-                                  face );
+      if ( sscanf( p, "%d %lf %lf",
+                   &base[count].count,
+                   &base[count].mean,
+                   &base[count].stddev ) != 3 )
+        continue;
+
+      p[-1] = '\0';
+      snprintf( base[count].key, sizeof ( base[count].key ), "%s", line );
+      count++;
     }
-    else
-      error = FT_New_Face( lib, filename, face_index, face );
 
-    if ( error )
-      fprintf( stderr, "couldn't load font resource\n");
+    fclose( file );
 
-    return error;
+    *acount = count;
+
+    return base;
   }
 
 
-  static void
-  usage( void )
+  /*
+   * Compare the results with a baseline using Welch's t-test; return the
+   * number of tests significantly slower than `regress_threshold' percent.
+   */
+
+  static int
+  compare_baseline( const char*  name )
   {
-    int   i;
-    char  interpreter_versions[32];
-    char  hinting_engines[32];
+    bbaseline_t*  base;
+    int           num_base, k, m;
+    int           regressions = 0;
+    char          key[1024];
 
 
-    /* we expect that at least one interpreter version is available */
-    if ( num_tt_interpreter_versions == 2 )
-      snprintf( interpreter_versions, sizeof ( interpreter_versions ),
-                "%u and %u",
-                tt_interpreter_versions[0],
-                tt_interpreter_versions[1] );
-    else
-      snprintf( interpreter_versions, sizeof ( interpreter_versions ),
-                "%u, %u, and %u",
-                tt_interpreter_versions[0],
-                tt_interpreter_versions[1],
-                tt_interpreter_versions[2] );
+    base = load_baseline( name, &num_base );
+    if ( !base )
+      return 0;
 
-    /* we expect that at least one hinting engine is available */
-    if ( num_ps_hinting_engines == 1 )
-      snprintf( hinting_engines, sizeof ( hinting_engines ),
-                "`%s'",
-                ps_hinting_engine_names[ps_hinting_engines[0]] );
-    else
-      snprintf( hinting_engines, sizeof ( hinting_engines ),
-                "`%s' and `%s'",
-                ps_hinting_engine_names[ps_hinting_engines[0]],
-                ps_hinting_engine_names[ps_hinting_engines[1]] );
+    printf( "\n"
+            "comparison with baseline `%s' (threshold %g%%):\n",
+            name, regress_threshold );
 
+    for ( k = 0; k < num_results; k++ )
+    {
+      bresult_t*    r = results + k;
+      bbaseline_t*  b;
+      double        delta, se2, t = 0.0;
+      int           significant;
 
-    fprintf( stderr,
-      "\n"
-      "ftbench: run FreeType benchmarks\n"
-      "--------------------------------\n"
-      "\n"
-      "Usage: ftbench [options] fontname\n"
-      "\n"
-      "  -C        Compare with cached version (if available).\n"
-      "  -c N      Use at most N iterations for each test\n"
-      "            (0 means time limited).\n"
-      "  -f L      Use hex number L as load flags (see `FT_LOAD_XXX').\n"
-      "  -H NAME   Use PS hinting engine NAME.\n"
-      "            Available versions are %s; default is `%s'.\n"
-      "  -I VER    Use TT interpreter version VER.\n"
-      "            Available versions are %s; default is version %u.\n"
-      "  -i I-J    Forward or reverse range of glyph indices to use\n"
-      "            (default is from 0 to the number of glyphs minus one).\n"
-      "  -l N      Set LCD filter to N\n"
-      "              0: none, 1: default, 2: light, 16: legacy\n"
-      "  -m M      Set maximum cache size to M KiByte (default is %d).\n",
-             hinting_engines,
-             ps_hinting_engine_names[dflt_ps_hinting_engine],
-             interpreter_versions,
-             dflt_tt_interpreter_version,
-             CACHE_SIZE );
-    fprintf( stderr,
-      "  -p        Preload font file in memory.\n"
-      "  -r N      Set render mode to N\n"
-      "              0: normal, 1: light, 2: mono, 3: LCD, 4: LCD vertical\n"
-      "            (default is 0).\n"
-      "  -s S      Use S ppem as face size (default is %dppem).\n"
-      "            If set to zero, don't call FT_Set_Pixel_Sizes.\n"
-      "            Use value 0 with option `-f 1' or something similar to\n"
-      "            load the glyphs unscaled, otherwise errors will show up.\n",
-             FACE_SIZE );
-    fprintf( stderr,
-      "  -t T      Use at most T seconds per bench (default is %.0f).\n"
-      "\n"
-      "  -b tests  Perform chosen tests (default is all):\n",
-             BENCH_TIME );
 
-    for ( i = 0; i < N_FT_BENCH; i++ )
-    {
-      if ( !bench_desc[i] )
-        break;
+      if ( !r->done )
+        continue;
 
-      fprintf( stderr,
-      "              %c  %s\n", 'a' + i, bench_desc[i] );
-    }
+      get_result_key( r, key, sizeof ( key ) );
+      for ( m = 0; m < num_base; m++ )
+        if ( !strcmp( key, base[m].key ) )
+          break;
 
-    fprintf( stderr,
-      "\n"
-      "  -v        Show version.\n"
-      "\n" );
+      printf( "  %-25s ", r->title );
 
-    exit( 1 );
-  }
+      if ( m == num_base )
+      {
+        printf( "not in baseline\n" );
+        continue;
+      }
+
+      b     = base + m;
+      delta = b->mean > 0 ? 100 * ( r->stats.mean - b->mean ) / b->mean
+                          : 0.0;
+
+      if ( r->stats.count > 1 && b->count > 1 )
+      {
+        double  v1 = b->stddev * b->stddev / b->count;
+        double  v2 = r->stats.stddev * r->stats.stddev / r->stats.count;
+        double  df;
+
+
+        se2 = v1 + v2;
+        if ( se2 > 0 )
+        {
+          /* Welch-Satterthwaite approximation of the degrees of freedom */
+          df = se2 * se2 /
+               ( v1 * v1 / ( b->count - 1 ) +
+                 v2 * v2 / ( r->stats.count - 1 ) );
+          t  = ( r->stats.mean - b->mean ) / sqrt( se2 );
+
+          significant = fabs( t ) > t_quantile( (int)df );
+        }
+        else
+          significant = r->stats.mean != b->mean;
+
+        printf( "%10.3f -> %10.3f us/op %+7.1f%%  t = %7.2f  %s",
+                b->mean, r->stats.mean, delta, t,
+                significant ? "significant" : "noise" );
+      }
+      else
+      {
+        /* too few samples for a test; judge the difference only */
+        significant = 1;
 
+        printf( "%10.3f -> %10.3f us/op %+7.1f%%",
+                b->mean, r->stats.mean, delta );
+      }
+
+      if ( significant && delta > regress_threshold )
+      {
+        printf( "  REGRESSION" );
+        regressions++;
+      }
+
+      printf( "\n" );
+    }
+
+    printf( "\n"
+            "%d test%s regressed\n",
+            regressions, regressions == 1 ? "" : "s" );
 
-#define TEST( x ) ( !test_string || strchr( test_string, (x) ) )
+    free( base );
+
+    return regressions;
+  }
 
 
   int
@@ -983,23 +9467,15 @@
   {
     FT_Face   face;
     FT_Error  error;
-
-    unsigned long  max_bytes      = CACHE_SIZE * 1024;
-    char*          test_string    = NULL;
-    unsigned int   size           = FACE_SIZE;
-    int            max_iter       = 0;
-    double         max_time       = BENCH_TIME;
-    int            compare_cached = 0;
-    size_t         i;
-    int            j;
+    int       corpus;
+    int       status = 0;
+    int       j;
 
     unsigned int  versions[3] = { TT_INTERPRETER_VERSION_35,
                                   TT_INTERPRETER_VERSION_38,
                                   TT_INTERPRETER_VERSION_40 };
     unsigned int  engines[2]  = { FT_HINTING_FREETYPE,
                                   FT_HINTING_ADOBE };
-    int           version;
-    char         *engine;
 
 #if defined _WIN32 && defined QPC
     LARGE_INTEGER  freq;
@@ -1029,9 +9505,6 @@
       if ( !error )
         tt_interpreter_versions[num_tt_interpreter_versions++] = versions[j];
     }
-    FT_Property_Set( lib,
-                     "truetype",
-                     "interpreter-version", &dflt_tt_interpreter_version );
 
     FT_Property_Get( lib,
                      "cff",
@@ -1044,38 +9517,51 @@
       if ( !error )
         ps_hinting_engines[num_ps_hinting_engines++] = engines[j];
     }
-    FT_Property_Set( lib,
-                     "cff",
-                     "hinting-engine", &dflt_ps_hinting_engine );
-    FT_Property_Set( lib,
-                     "type1",
-                     "hinting-engine", &dflt_ps_hinting_engine );
-    FT_Property_Set( lib,
-                     "t1cid",
-                     "hinting-engine", &dflt_ps_hinting_engine );
-
 
-    version = (int)dflt_tt_interpreter_version;
-    engine  = ps_hinting_engine_names[dflt_ps_hinting_engine];
+    tt_interpreter_version = dflt_tt_interpreter_version;
+    ps_hinting_engine      = dflt_ps_hinting_engine;
 
     while ( 1 )
     {
       int  opt;
 
 
-      opt = getopt( argc, argv, "b:Cc:f:H:I:i:l:m:pr:s:t:v" );
+      opt = getopt( argc, argv, "a:B:b:Cc:DdEef:g:H:I:i:j:K:l:L:Mm:O:o:PpR:r:S:s:T:t:U:vW:w:XY:y:Z:" );
 
       if ( opt == -1 )
         break;
 
       switch ( opt )
       {
+      case 'a':
+        target_error = atof( optarg );
+        if ( target_error < 0 )
+          target_error = -target_error;
+        break;
+
+      case 'B':
+        baseline_save = optarg;
+        break;
+
       case 'b':
         test_string = optarg;
         break;
 
-      case 'C':
-        compare_cached = 1;
+      case 'C':
+        compare_cached = 1;
+        break;
+
+      case 'D':
+#ifdef BENCH_COLD
+        cold_start = 1;
+#else
+        fprintf( stderr,
+                 "warning: cold-start runs not supported\n" );
+#endif
+        break;
+
+      case 'd':
+        show_stats = 1;
         break;
 
       case 'c':
@@ -1084,26 +9570,35 @@
           max_iter = -max_iter;
         break;
 
+      case 'e':
+#ifdef BENCH_PERF
+        use_counters = 1;
+#else
+        fprintf( stderr,
+                 "warning: hardware counters not supported\n" );
+#endif
+        break;
+
+      case 'E':
+        engine_matrix = 1;
+        break;
+
       case 'f':
         load_flags = strtol( optarg, NULL, 16 );
         break;
 
-      case 'H':
-        engine = optarg;
+      case 'g':
+        profile_top = atoi( optarg );
+        if ( profile_top < 0 )
+          profile_top = 0;
+        break;
 
+      case 'H':
         for ( j = 0; j < num_ps_hinting_engines; j++ )
         {
-          if ( !strcmp( engine, ps_hinting_engine_names[j] ) )
+          if ( !strcmp( optarg, ps_hinting_engine_names[j] ) )
           {
-            FT_Property_Set( lib,
-                             "cff",
-                             "hinting-engine", &j );
-            FT_Property_Set( lib,
-                             "type1",
-                             "hinting-engine", &j );
-            FT_Property_Set( lib,
-                             "t1cid",
-                             "hinting-engine", &j );
+            ps_hinting_engine = (unsigned int)j;
             break;
           }
         }
@@ -1114,22 +9609,23 @@
         break;
 
       case 'I':
-        version = atoi( optarg );
-
-        for ( j = 0; j < num_tt_interpreter_versions; j++ )
         {
-          if ( version == (int)tt_interpreter_versions[j] )
+          int  version = atoi( optarg );
+
+
+          for ( j = 0; j < num_tt_interpreter_versions; j++ )
           {
-            FT_Property_Set( lib,
-                             "truetype",
-                             "interpreter-version", &version );
-            break;
+            if ( version == (int)tt_interpreter_versions[j] )
+            {
+              tt_interpreter_version = (unsigned int)version;
+              break;
+            }
           }
-        }
 
-        if ( j == num_tt_interpreter_versions )
-          fprintf( stderr,
-                   "warning: couldn't set TT interpreter version\n" );
+          if ( j == num_tt_interpreter_versions )
+            fprintf( stderr,
+                     "warning: couldn't set TT interpreter version\n" );
+        }
         break;
 
       case 'i':
@@ -1138,12 +9634,32 @@
 
           if ( sscanf( optarg, "%u%*[,:-]%u", &fi, &li ) == 2 )
           {
-            first_index = fi;
-            last_index  = li;
+            first_index_arg = fi;
+            last_index_arg  = li;
           }
         }
         break;
 
+      case 'j':
+        num_threads = atoi( optarg );
+        if ( num_threads < 1 )
+          num_threads = 1;
+        if ( num_threads > MAX_THREADS )
+          num_threads = MAX_THREADS;
+#ifndef BENCH_THREADS
+        if ( num_threads > 1 )
+        {
+          fprintf( stderr,
+                   "warning: multi-threaded runs not supported\n" );
+          num_threads = 1;
+        }
+#endif
+        break;
+
+      case 'K':
+        parse_cache_sweep( optarg );
+        break;
+
       case 'l':
         {
           int  filter = atoi( optarg );
@@ -1156,11 +9672,38 @@
           case FT_LCD_FILTER_LIGHT:
           case FT_LCD_FILTER_LEGACY1:
           case FT_LCD_FILTER_LEGACY:
-            FT_Library_SetLcdFilter( lib, (FT_LcdFilter)filter );
+            lcd_filter      = filter;
+            use_lcd_weights = 0;
+          }
+        }
+        break;
+
+      case 'L':
+        {
+          int  i, w[5];
+
+
+          i = sscanf( optarg, "%d,%d,%d,%d,%d",
+                      w, w + 1, w + 2, w + 3, w + 4 );
+          if ( i == 5 )
+          {
+            for ( i = 0; i < 5; i++ )
+              lcd_weights[i] = (unsigned char)w[i];
+
+            use_lcd_weights = 1;
+            lcd_filter      = -1;
           }
+          else
+            fprintf( stderr,
+                     "warning: couldn't parse LCD filter weights `%s'\n",
+                     optarg );
         }
         break;
 
+      case 'M':
+        show_memory = 1;
+        break;
+
       case 'm':
         {
           int  mb = atoi( optarg );
@@ -1171,10 +9714,35 @@
         }
         break;
 
+      case 'o':
+        output_name = optarg;
+        break;
+
+      case 'O':
+        {
+          char*  end;
+
+
+          stream_mode    = 1;
+          stream_latency = strtoul( optarg, &end, 10 );
+          stream_chunk   = *end == ',' ? strtoul( end + 1, &end, 10 ) : 0;
+          if ( *end )
+            usage();
+        }
+        break;
+
+      case 'P':
+        preload = 2;
+        break;
+
       case 'p':
         preload = 1;
         break;
 
+      case 'R':
+        baseline_compare = optarg;
+        break;
+
       case 'r':
         {
           int  rm = atoi( optarg );
@@ -1187,6 +9755,10 @@
         }
         break;
 
+      case 'S':
+        parse_sizes( optarg );
+        break;
+
       case 's':
         {
           int  sz = atoi( optarg );
@@ -1194,18 +9766,35 @@
 
           /* value 0 is special */
           if ( sz < 0 )
-            size = 1;
+            face_size_arg = 1;
           else
-            size = (unsigned int)sz;
+            face_size_arg = (unsigned int)sz;
         }
         break;
 
+      case 'T':
+        regress_threshold = atof( optarg );
+        break;
+
       case 't':
         max_time = atof( optarg );
         if ( max_time < 0 )
           max_time = -max_time;
         break;
 
+      case 'U':
+        share_threads = atoi( optarg );
+        if ( share_threads < 1 )
+          share_threads = 1;
+        if ( share_threads > MAX_THREADS )
+          share_threads = MAX_THREADS;
+#ifndef BENCH_THREADS
+        fprintf( stderr,
+                 "warning: multi-threaded runs not supported\n" );
+        share_threads = 0;
+#endif
+        break;
+
       case 'v':
         {
           FT_Int  major, minor, patch;
@@ -1221,6 +9810,48 @@
         }
         /* break; */
 
+      case 'W':
+        if ( load_workload( optarg ) )
+          workload_name = optarg;
+        break;
+
+      case 'w':
+        warmup_iter = atoi( optarg );
+        if ( warmup_iter < 0 )
+          warmup_iter = 0;
+        break;
+
+      case 'X':
+        render_matrix = 1;
+        break;
+
+      case 'Y':
+#ifdef BENCH_SAMPLER
+        if ( optarg[0] >= 'a'                &&
+             optarg[0] < 'a' + N_FT_BENCH    &&
+             !optarg[1]                      )
+        {
+          sample_test = optarg[0] - 'a';
+          test_string = optarg;
+        }
+        else
+          fprintf( stderr, "warning: no test `%s' to profile\n", optarg );
+#else
+        fprintf( stderr,
+                 "warning: sampling profiler not supported\n" );
+#endif
+        break;
+
+      case 'y':
+#ifdef BENCH_SAMPLER
+        folded_name = optarg;
+#endif
+        break;
+
+      case 'Z':
+        zipf_exponent = atof( optarg );
+        break;
+
       default:
         usage();
         break;
@@ -1230,274 +9861,157 @@
     argc -= optind;
     argv += optind;
 
-    if ( argc != 1 )
+    if ( argc < 1 )
       usage();
 
-    filename = *argv;
-
-    if ( get_face( &face ) )
-      goto Exit;
-
-    if ( first_index >= (unsigned int)face->num_glyphs )
-      first_index = (unsigned int)face->num_glyphs - 1;
-    if ( last_index  >= (unsigned int)face->num_glyphs )
-      last_index  = (unsigned int)face->num_glyphs - 1;
-    incr_index  = last_index > first_index ? 1 : -1;
+    /* in cold-start mode, the face kept open for the settings must not */
+    /* map the file, otherwise the kernel can't drop its pages          */
+    if ( cold_start )
+    {
+      if ( preload )
+        fprintf( stderr, "warning: `-p' and `-P' are ignored with `-D'\n" );
+      preload = 1;
+    }
 
-    if ( size )
+#ifdef BENCH_SAMPLER
+    /* `SIGPROF' goes to any thread, so profile only the main thread */
+    if ( sample_test >= 0 )
     {
-      if ( FT_IS_SCALABLE( face ) )
-      {
-        if ( FT_Set_Pixel_Sizes( face, size, size ) )
-        {
-          fprintf( stderr, "failed to set pixel size to %u\n", size );
+      if ( num_threads > 1 )
+        fprintf( stderr, "warning: no multi-threaded runs with `-Y'\n" );
+      num_threads = 1;
 
-          return 1;
-        }
-      }
-      else
+      if ( !sampler_init() )
       {
-        size = (unsigned int)face->available_sizes[0].size >> 6;
-        fprintf( stderr,
-                 "using size of first bitmap strike (%upx)\n", size );
-        FT_Select_Size( face, 0 );
+        fprintf( stderr, "warning: couldn't set up the sampler\n" );
+        sample_test = -1;
       }
     }
+#endif
 
-    FTC_Manager_New( lib,
-                     0,
-                     0,
-                     max_bytes,
-                     face_requester,
-                     face,
-                     &cache_man );
-
-    font_type.face_id = (FTC_FaceID)1;
-    font_type.width   = size;
-    font_type.height  = size;
-    font_type.flags   = load_flags;
-
-    printf( "\n"
-            "ftbench results for font `%s'\n"
-            "---------------------------",
-            filename );
-    for ( i = 0; i < strlen( filename ); i++ )
-      putchar( '-' );
-    putchar( '\n' );
+    /* a single font file is benchmarked as before, with face index 0 */
+    corpus = argc > 1;
 
-    printf( "\n"
-            "family: %s\n"
-            " style: %s\n"
-            "\n",
-            face->family_name,
-            face->style_name );
+    for ( ; argc > 0; argc--, argv++ )
+    {
+      if ( argv[0][0] == '@' )
+      {
+        add_font_list( argv[0] + 1 );
+        corpus = 1;
+      }
+      else if ( add_font_dir( argv[0] ) )
+        corpus = 1;
+      else
+        add_font_file( argv[0] );
+    }
 
-    if ( max_iter )
-      printf( "number of iterations for each test: at most %d\n",
-              max_iter );
-    printf( "number of seconds for each test: %s%f\n",
-             max_iter ? "at most " : "",
-             max_time );
+    /* set up the library again with the chosen properties */
+    FT_Done_FreeType( lib );
 
-    printf( "\n"
-            "glyph indices: from %u to %u\n"
-            "face size: %uppem\n"
-            "font preloading into memory: %s\n",
-            first_index,
-            last_index,
-            size,
-            preload ? "yes" : "no" );
+    if ( library_init() )
+    {
+      fprintf( stderr, "could not initialize font library\n" );
 
-    printf( "\n"
-            "load flags: 0x%X\n"
-            "render mode: %u\n",
-            load_flags,
-            render_mode );
-    printf( "\n"
-            "CFF hinting engine set to `%s'\n"
-            "TrueType interpreter set to version %d\n"
-            "maximum cache size: %luKiByte\n",
-            engine,
-            version,
-            max_bytes / 1024 );
+      return 1;
+    }
 
-    printf( "\n"
-            "executing tests:\n" );
+#ifdef BENCH_PERF
+    if ( use_counters && !perf_init() )
+    {
+      fprintf( stderr,
+               "warning: couldn't open hardware counters"
+               " (check `/proc/sys/kernel/perf_event_paranoid')\n" );
+      use_counters = 0;
+    }
+#endif
 
-    for ( j = 0; j < N_FT_BENCH; j++ )
+    if ( !corpus )
     {
-      btest_t   test;
-      FT_ULong  flags;
+      filename = font_files[0];
+      bench_face( 0 );
+    }
+    else
+    {
+      int  num_faces = 0;
 
 
-      if ( !TEST( 'a' + j ) )
-        continue;
+      printf( "\n"
+              "ftbench results for %d font files\n"
+              "-----------------------------------\n",
+              num_font_files );
 
-      test.title       = NULL;
-      test.bench       = NULL;
-      test.cache_first = 0;
-      test.user_data   = NULL;
+      first_index = first_index_arg;
+      last_index  = last_index_arg;
+      face_size   = face_size_arg;
+      print_settings();
 
-      switch ( j )
+      for ( j = 0; j < num_font_files; j++ )
       {
-      case FT_BENCH_LOAD_GLYPH:
-        test.title = "Load";
-        test.bench = test_load;
-        benchmark( face, &test, max_iter, max_time );
-
-        if ( compare_cached )
-        {
-          test.cache_first = 1;
-
-          test.title = "Load (image cached)";
-          test.bench = test_image_cache;
-          benchmark( face, &test, max_iter, max_time );
-
-          test.title = "Load (sbit cached)";
-          test.bench = test_sbit_cache;
-          if ( size )
-            benchmark( face, &test, max_iter, max_time );
-          else
-            printf( "  %-25s disabled (size = 0)\n", test.title );
-        }
-        break;
-
-      case FT_BENCH_LOAD_ADVANCES:
-        test.user_data = &flags;
-
-        test.title = "Load_Advances (Normal)";
-        test.bench = test_load_advances;
-        flags      = FT_LOAD_DEFAULT;
-        benchmark( face, &test, max_iter, max_time );
-
-        test.title  = "Load_Advances (Fast)";
-        test.bench  = test_load_advances;
-        flags       = FT_LOAD_TARGET_LIGHT;
-        benchmark( face, &test, max_iter, max_time );
+        long  num_sub, n;
 
-        test.title  = "Load_Advances (Unscaled)";
-        test.bench  = test_load_advances;
-        flags       = FT_LOAD_NO_SCALE;
-        benchmark( face, &test, max_iter, max_time );
-        break;
-
-      case FT_BENCH_RENDER:
-        test.title = "Render";
-        test.bench = test_render;
-        if ( size )
-          benchmark( face, &test, max_iter, max_time );
-        else
-          printf( "  %-25s disabled (size = 0)\n", test.title );
-        break;
-
-      case FT_BENCH_GET_GLYPH:
-        test.title = "Get_Glyph";
-        test.bench = test_get_glyph;
-        benchmark( face, &test, max_iter, max_time );
-        break;
 
-      case FT_BENCH_GET_CBOX:
-        test.title = "Get_CBox";
-        test.bench = test_get_cbox;
-        benchmark( face, &test, max_iter, max_time );
-        break;
+        filename = font_files[j];
+        if ( !filename )
+          continue;
 
-      case FT_BENCH_GET_BBOX:
-        test.title = "Get_BBox";
-        test.bench = test_get_bbox;
-        benchmark( face, &test, max_iter, max_time );
-        break;
+        /* don't complain about non-font files in directories */
+        if ( FT_New_Face( lib, filename, -1, &face ) )
+          continue;
+        num_sub = face->num_faces;
+        FT_Done_Face( face );
 
-      case FT_BENCH_CMAP:
+        for ( n = 0; n < num_sub; n++ )
         {
-          bcharset_t  charset;
-
-
-          get_charset( face, &charset );
-          if ( charset.code )
-          {
-            test.user_data = (void*)&charset;
-
+          long  num_instances, k;
 
-            test.title = "Get_Char_Index";
-            test.bench = test_get_char_index;
-
-            benchmark( face, &test, max_iter, max_time );
-
-            if ( compare_cached )
-            {
-              test.cache_first = 1;
 
-              test.title = "Get_Char_Index (cached)";
-              test.bench = test_cmap_cache;
-              benchmark( face, &test, max_iter, max_time );
-            }
+          if ( FT_New_Face( lib, filename, -( n + 1 ), &face ) )
+            continue;
+          num_instances = face->style_flags >> 16;
+          FT_Done_Face( face );
 
-            free( charset.code );
+          /* the default instance first, then all named instances */
+          for ( k = 0; k <= num_instances; k++ )
+          {
+            face_index = ( k << 16 ) + n;
+            if ( !bench_face( 1 ) )
+              num_faces++;
           }
         }
-        break;
+      }
 
-      case FT_BENCH_CMAP_ITER:
-        test.title = "Iterate CMap";
-        test.bench = test_cmap_iter;
-        benchmark( face, &test, max_iter, max_time );
-        break;
+      printf( "\n"
+              "%d faces benchmarked\n",
+              num_faces );
 
-      case FT_BENCH_NEW_FACE:
-        test.title = "New_Face";
-        test.bench = test_new_face;
-        benchmark( face, &test, max_iter, max_time );
-        break;
+      print_aggregates( 0 );
+    }
 
-      case FT_BENCH_EMBOLDEN:
-        test.title = "Embolden";
-        test.bench = test_embolden;
-        if ( size )
-          benchmark( face, &test, max_iter, max_time );
-        else
-          printf( "  %-25s disabled (size = 0)\n", test.title );
-        break;
+    if ( output_name )
+      write_results( output_name );
 
-      case FT_BENCH_STROKE:
-        test.title = "Stroke";
-        test.bench = test_stroke;
-        if ( size )
-          benchmark( face, &test, max_iter, max_time );
-        else
-          printf( "  %-25s disabled (size = 0)\n", test.title );
-        break;
+    if ( baseline_save )
+      save_baseline( baseline_save );
 
-      case FT_BENCH_NEW_FACE_AND_LOAD_GLYPH:
-        test.title = "New_Face & load glyph(s)";
-        test.bench = test_new_face_and_load_glyph;
-        benchmark( face, &test, max_iter, max_time );
-        break;
-      }
-    }
+    if ( baseline_compare && compare_baseline( baseline_compare ) )
+      status = 2;
 
-  Exit:
-    /* The following is a bit subtle: When we call FTC_Manager_Done, this
-     * normally destroys all FT_Face objects that the cache might have
-     * created by calling the face requester.
-     *
-     * However, this little benchmark uses a tricky face requester that
-     * doesn't create a new FT_Face through FT_New_Face but simply passes a
-     * pointer to the one that was previously created.
-     *
-     * If the cache manager has been used before, the call to
-     * FTC_Manager_Done discards our single FT_Face.
-     *
-     * In the case where no cache manager is in place, or if no test was
-     * run, the call to FT_Done_FreeType releases any remaining FT_Face
-     * object anyway.
-     */
-    if ( cache_man )
-      FTC_Manager_Done( cache_man );
+    library_done();
 
-    FT_Done_FreeType( lib );
+#ifdef BENCH_PERF
+    if ( use_counters )
+      perf_done();
+#endif
+#ifdef BENCH_SAMPLER
+    sampler_done();
+#endif
+    free_results( results, num_results );
 
-    return 0;
+    for ( j = 0; j < num_font_files; j++ )
+      free( font_files[j] );
+    free( font_files );
+
+    return status;
   }
 
 
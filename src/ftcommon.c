@@ -43,6 +43,13 @@
 #include <string.h>
 #include <stdarg.h>
 
+#ifdef UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 
 #ifdef _WIN32
 #define strcasecmp  _stricmp
@@ -332,6 +339,98 @@
   }
 
 
+  /* Map a font file into memory; without `mmap', read it instead. */
+  static FT_Error
+  map_file( const char*  filepath,
+            void**       aaddress,
+            size_t*      asize,
+            int*         amapped )
+  {
+    FILE*   file;
+    size_t  file_size;
+
+
+#ifdef UNIX
+    struct stat  st;
+    void*        address = MAP_FAILED;
+    int          fd      = open( filepath, O_RDONLY );
+
+
+    if ( fd < 0 )
+      return FT_Err_Cannot_Open_Resource;
+
+    if ( !fstat( fd, &st ) && st.st_size > 0 )
+      address = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+                      fd, 0 );
+    close( fd );
+
+    if ( address != MAP_FAILED )
+    {
+      *aaddress = address;
+      *asize    = (size_t)st.st_size;
+      *amapped  = 1;
+
+      return FT_Err_Ok;
+    }
+#endif
+
+    file = fopen( filepath, "rb" );
+    if ( file == NULL )
+      return FT_Err_Cannot_Open_Resource;
+
+    fseek( file, 0, SEEK_END );
+    file_size = (size_t)ftell( file );
+    fseek( file, 0, SEEK_SET );
+
+    if ( file_size <= 0 )
+    {
+      fclose( file );
+      return FT_Err_Invalid_Stream_Operation;
+    }
+
+    *aaddress = malloc( file_size );
+    if ( !*aaddress )
+    {
+      fclose( file );
+      return FT_Err_Out_Of_Memory;
+    }
+
+    if ( !fread( *aaddress, file_size, 1, file ) )
+    {
+      free( *aaddress );
+      fclose( file );
+      return FT_Err_Invalid_Stream_Read;
+    }
+
+    fclose( file );
+
+    *asize   = file_size;
+    *amapped = 0;
+
+    return FT_Err_Ok;
+  }
+
+
+  static void
+  unmap_file( void*   address,
+              size_t  size,
+              int     mapped )
+  {
+#ifdef UNIX
+    if ( mapped )
+    {
+      munmap( address, size );
+      return;
+    }
+#else
+    FT_UNUSED( size );
+    FT_UNUSED( mapped );
+#endif
+
+    free( address );
+  }
+
+
   FTDemo_Handle*
   FTDemo_New( void )
   {
@@ -397,17 +496,6 @@
     if ( !handle )
       return;
 
-    for ( i = 0; i < handle->max_fonts; i++ )
-    {
-      if ( handle->fonts[i] )
-      {
-        if ( handle->fonts[i]->filepathname )
-          free( (void*)handle->fonts[i]->filepathname );
-        free( handle->fonts[i] );
-      }
-    }
-    free( handle->fonts );
-
     /* string_done */
     for ( i = 0; i < MAX_GLYPHS; i++ )
     {
@@ -423,6 +511,25 @@
     FTC_Manager_Done( handle->cache_manager );
     FT_Done_FreeType( handle->library );
 
+    /* preloaded files may only go away after their faces */
+    for ( i = 0; i < handle->max_fonts; i++ )
+    {
+      PFont  font = handle->fonts[i];
+
+
+      if ( font )
+      {
+        if ( font->filepathname )
+          free( (void*)font->filepathname );
+        if ( font->file_owner )
+          unmap_file( font->file_address,
+                      font->file_size,
+                      font->file_mapped );
+        free( font );
+      }
+    }
+    free( handle->fonts );
+
     free( handle );
   }
 
@@ -530,7 +637,12 @@
                        FT_Bool         no_instances )
   {
     long          i, num_faces;
-    FT_Face       face;
+    FT_Face       face           = NULL;
+    PFont         font           = NULL;
+    void*         shared_address = NULL;    /* for `PRELOAD_MMAP' */
+    size_t        shared_size    = 0;
+    int           shared_mapped  = 0;
+    int           shared_owned   = 0;
 
 
     /* We use a conservative approach here, at the cost of calling     */
@@ -545,12 +657,23 @@
       return error;
     num_faces = face->num_faces;
     FT_Done_Face( face );
+    face = NULL;
+
+    /* all faces and named instances share a single mapping */
+    if ( handle->preload == PRELOAD_MMAP )
+    {
+      error = map_file( filepath,
+                        &shared_address,
+                        &shared_size,
+                        &shared_mapped );
+      if ( error )
+        return error;
+    }
 
     /* allocate new font object(s) */
     for ( i = 0; i < num_faces; i++ )
     {
-      PFont  font;
-      long   j, instance_count;
+      long  j, instance_count;
 
 
       error = FT_New_Face( handle->library, filepath, -( i + 1 ), &face );
@@ -558,6 +681,7 @@
         continue;
       instance_count = no_instances ? 0 : face->style_flags >> 16;
       FT_Done_Face( face );
+      face = NULL;
 
       /* load face with and without named instances */
       for ( j = 0; j < instance_count + 1; j++ )
@@ -572,14 +696,24 @@
         if ( outline_only && !FT_IS_SCALABLE( face ) )
         {
           FT_Done_Face( face );
+          face = NULL;
           continue;
         }
 
         font = (PFont)malloc( sizeof ( *font ) );
+        if ( !font )
+        {
+          error = FT_Err_Out_Of_Memory;
+          goto Exit;
+        }
 
         font->filepathname = ft_strdup( filepath );
         if ( !font->filepathname )
-          return FT_Err_Out_Of_Memory;
+        {
+          error = FT_Err_Out_Of_Memory;
+          free( font );
+          goto Exit;
+        }
 
         font->face_index = ( j << 16 ) + i;
 
@@ -592,7 +726,16 @@
 
         font->palette_index = 0;
 
-        if ( handle->preload )
+        if ( handle->preload == PRELOAD_MMAP )
+        {
+          font->file_address = shared_address;
+          font->file_size    = shared_size;
+          font->file_mapped  = shared_mapped;
+          font->file_owner   = !shared_owned;    /* the first font */
+
+          shared_owned = 1;
+        }
+        else if ( handle->preload )
         {
           FILE*   file = fopen( filepath, "rb" );
           size_t  file_size;
@@ -600,9 +743,8 @@
 
           if ( file == NULL )  /* shouldn't happen */
           {
-            free( (void*)font->filepathname );
-            free( font );
-            return FT_Err_Invalid_Argument;
+            error = FT_Err_Invalid_Argument;
+            goto Fail;
           }
 
           fseek( file, 0, SEEK_END );
@@ -611,28 +753,30 @@
 
           if ( file_size <= 0 )
           {
-            free( font );
             fclose( file );
-            return FT_Err_Invalid_Stream_Operation;
+            error = FT_Err_Invalid_Stream_Operation;
+            goto Fail;
           }
 
           font->file_address = malloc( file_size );
           if ( !font->file_address )
           {
-            free( font );
             fclose( file );
-            return FT_Err_Out_Of_Memory;
+            error = FT_Err_Out_Of_Memory;
+            goto Fail;
           }
 
           if ( !fread( font->file_address, file_size, 1, file ) )
           {
             free( font->file_address );
-            free( font );
             fclose( file );
-            return FT_Err_Invalid_Stream_Read;
+            error = FT_Err_Invalid_Stream_Read;
+            goto Fail;
           }
 
-          font->file_size = file_size;
+          font->file_size   = file_size;
+          font->file_mapped = 0;
+          font->file_owner  = 1;
 
           fclose( file );
         }
@@ -640,6 +784,8 @@
         {
           font->file_address = NULL;
           font->file_size    = 0;
+          font->file_mapped  = 0;
+          font->file_owner   = 0;
         }
 
         FT_Done_Face( face );
@@ -667,7 +813,22 @@
       }
     }
 
-    return FT_Err_Ok;
+    error = FT_Err_Ok;
+    goto Exit;
+
+  Fail:
+    free( (void*)font->filepathname );
+    free( font );
+
+  Exit:
+    if ( face )
+      FT_Done_Face( face );
+
+    /* nobody has taken over the mapping */
+    if ( shared_address && !shared_owned )
+      unmap_file( shared_address, shared_size, shared_mapped );
+
+    return error;
   }
 
 
@@ -807,7 +968,7 @@
   FTDemo_Set_Preload( FTDemo_Handle*  handle,
                       int             preload )
   {
-    handle->preload = !!preload;
+    handle->preload = preload;
   }
 
 
@@ -147,6 +147,8 @@
     int          num_indices;
     void*        file_address;  /* for preloaded files */
     size_t       file_size;
+    int          file_mapped;   /* `file_address' comes from `mmap' */
+    int          file_owner;    /* release `file_address' when done */
 
   } TFont, *PFont;
 
@@ -260,6 +262,13 @@
                        FT_Bool         no_instances );
 
 
+  /* values for `FTDemo_Set_Preload' */
+  enum {
+    PRELOAD_NONE = 0,
+    PRELOAD_READ,      /* read the file into memory for every face   */
+    PRELOAD_MMAP       /* map the file once, shared by all its faces */
+  };
+
   void
   FTDemo_Set_Preload( FTDemo_Handle*  handle,
                       int             preload );
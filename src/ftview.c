@@ -1617,6 +1617,7 @@
     fprintf( stderr,
       "  -L N,...  Set LCD filter or geometry by comma-separated values.\n"
       "  -p        Preload file in memory to simulate memory-mapping.\n"
+      "  -P        Memory-map font files, once for all faces of a file.\n"
       "\n"
       "  -v        Show version.\n"
       "\n" );
@@ -1637,7 +1638,7 @@
 
     while ( 1 )
     {
-      option = getopt( *argc, *argv, "d:e:f:k:L:l:m:pr:v" );
+      option = getopt( *argc, *argv, "d:e:f:k:L:l:m:Ppr:v" );
 
       if ( option == -1 )
         break;
@@ -1716,8 +1717,12 @@
         status.render_mode = RENDER_MODE_TEXT;
         break;
 
+      case 'P':
+        status.preload = PRELOAD_MMAP;
+        break;
+
       case 'p':
-        status.preload = 1;
+        status.preload = PRELOAD_READ;
         break;
 
       case 'r':
@@ -1772,7 +1777,7 @@
                                (FT_LcdFilter)status.lcd_filter );
 
     if ( status.preload )
-      FTDemo_Set_Preload( handle, 1 );
+      FTDemo_Set_Preload( handle, status.preload );
 
     for ( ; argc > 0; argc--, argv++ )
       FTDemo_Install_Font( handle, argv[0], 0, 0 );